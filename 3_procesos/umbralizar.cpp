@@ -1,7 +1,10 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cstring>
+#include <chrono>
 #include <unistd.h>
+#include <sys/mman.h>
 #include <sys/wait.h>
 
 using namespace std;
@@ -32,34 +35,48 @@ struct BMPHeader {
 };
 #pragma pack(pop)
 
-vector<vector<Pixel>> leerArchivoBMP(const char* nombreArchivo) {
-    ifstream archivo(nombreArchivo, ios::binary);
+// La lectura del archivo y su decodificación se separan para poder medir cada fase por separado
+vector<char> leerArchivo(const char* nombreArchivo) {
+    ifstream archivo(nombreArchivo, ios::binary | ios::ate);
 
     if (!archivo) {
         cerr << "No se pudo abrir el archivo BMP" << endl;
         exit(1);
     }
 
+    vector<char> datos(archivo.tellg());
+    archivo.seekg(0, ios::beg);
+    archivo.read(datos.data(), datos.size());
+    archivo.close();
+    return datos;
+}
+
+vector<vector<Pixel>> decodificarBMP(const vector<char>& datos) {
     BMPHeader header;
-    archivo.read(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    if (datos.size() < sizeof(BMPHeader)) {
+        cerr << "El archivo BMP está incompleto" << endl;
+        exit(1);
+    }
+    memcpy(&header, datos.data(), sizeof(BMPHeader));
 
     if (header.bitsPerPixel != 24) {
         cerr << "El archivo BMP debe tener 24 bits por píxel" << endl;
         exit(1);
     }
 
-    // Mover el puntero al inicio de los datos de píxeles
-    archivo.seekg(header.dataOffset, ios::beg);
+    // Cada fila ocupa 3 bytes por píxel más el relleno para la alineación de 4 bytes
+    size_t tamanoFila = 3 * header.width + header.width % 4;
+    if (header.dataOffset + tamanoFila * header.height > datos.size()) {
+        cerr << "El archivo BMP está incompleto" << endl;
+        exit(1);
+    }
 
     vector<vector<Pixel>> matriz(header.height, vector<Pixel>(header.width));
 
-    for (int i = 0; i < header.height; ++i) {
-        for (int j = 0; j < header.width; ++j) {
-            archivo.read(reinterpret_cast<char*>(&matriz[i][j]), sizeof(Pixel));
-        }
-        archivo.seekg(header.width % 4, ios::cur);
+    const char* fila = datos.data() + header.dataOffset;
+    for (int i = 0; i < header.height; ++i, fila += tamanoFila) {
+        memcpy(matriz[i].data(), fila, sizeof(Pixel) * header.width);
     }
-    archivo.close();
     return matriz;
 }
 
@@ -72,14 +89,7 @@ void umbralizar(Pixel& pixel, unsigned char umbral) {
     }
 }
 
-void guardarMatrizEnBMP(const char* nombreArchivo, const vector<vector<Pixel>>& matriz) {
-    ofstream archivo(nombreArchivo, ios::binary);
-
-    if (!archivo) {
-        cerr << "No se pudo crear el archivo BMP" << endl;
-        exit(1);
-    }
-
+vector<char> codificarBMP(const vector<vector<Pixel>>& matriz) {
     BMPHeader header;
     header.signature[0] = 'B';
     header.signature[1] = 'M';
@@ -98,22 +108,34 @@ void guardarMatrizEnBMP(const char* nombreArchivo, const vector<vector<Pixel>>&
     header.colors = 0;
     header.importantColors = 0;
 
-    archivo.write(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    // El relleno para la alineación de 4 bytes queda en 0 porque el vector se crea con ceros
+    size_t tamanoFila = 3 * matriz[0].size() + matriz[0].size() % 4;
+    vector<char> datos(sizeof(BMPHeader) + matriz.size() * tamanoFila);
+    memcpy(datos.data(), &header, sizeof(BMPHeader));
 
-    // Escribir la matriz en el archivo BMP
-    for (int i = 0; i < matriz.size(); ++i) {
-        for (int j = 0; j < matriz[0].size(); ++j) {
-            archivo.write(reinterpret_cast<const char*>(&matriz[i][j]), sizeof(Pixel));
-        }
-        // Rellenar con bytes de 0 para la alineación de 4 bytes
-        for (int k = 0; k < matriz[0].size() % 4; ++k) {
-            char paddingByte = 0;
-            archivo.write(&paddingByte, 1);
-        }
+    char* fila = datos.data() + sizeof(BMPHeader);
+    for (size_t i = 0; i < matriz.size(); ++i, fila += tamanoFila) {
+        memcpy(fila, matriz[i].data(), sizeof(Pixel) * matriz[0].size());
+    }
+    return datos;
+}
+
+void escribirArchivo(const char* nombreArchivo, const vector<char>& datos) {
+    ofstream archivo(nombreArchivo, ios::binary);
+
+    if (!archivo) {
+        cerr << "No se pudo crear el archivo BMP" << endl;
+        exit(1);
     }
+
+    archivo.write(datos.data(), datos.size());
     archivo.close();
 }
 
+long long microsegundosDesde(chrono::high_resolution_clock::time_point inicio) {
+    return chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - inicio).count();
+}
+
 int main(int argc, char* argv[]) {
     if (argc != 4) {
         cerr << "Uso: " << argv[0] << " <nombre_del_archivo_entrada.bmp> <nombre_del_archivo_salida.bmp> <umbral>" << endl;
@@ -123,8 +145,14 @@ int main(int argc, char* argv[]) {
     const char* nombreArchivoEscrituraBMP = argv[2];
     unsigned char umbral = static_cast<unsigned char>(stoi(argv[3]));
 
-    // Leer el archivo BMP y obtener la matriz de píxeles
-    vector<vector<Pixel>> matriz = leerArchivoBMP(nombreArchivoLecturaBMP);
+    // Cada fase se mide por separado: lectura del archivo, decodificación, umbralizado, codificación y escritura
+    auto inicio = chrono::high_resolution_clock::now();
+    vector<char> datos = leerArchivo(nombreArchivoLecturaBMP);
+    long long tiempoLectura = microsegundosDesde(inicio);
+
+    inicio = chrono::high_resolution_clock::now();
+    vector<vector<Pixel>> matriz = decodificarBMP(datos);
+    long long tiempoDecodificacion = microsegundosDesde(inicio);
 
     std::cout << std::endl << "MEDICIÓN DE FORMA PROCESOS. .........." << std::endl;
     auto start_time = std::chrono::high_resolution_clock::now();
@@ -134,21 +162,38 @@ int main(int argc, char* argv[]) {
     int tamanoBloque = matriz.size() / numProcesos;
     vector<pid_t> pids(numProcesos);
 
+    // Los hijos no comparten la memoria del padre, así que los píxeles y el tiempo de cada proceso van en una región
+    // compartida que el padre copia de vuelta a la matriz al terminar
+    size_t ancho = matriz[0].size();
+    size_t bytesPixeles = matriz.size() * ancho * sizeof(Pixel);
+    void* region = mmap(nullptr, bytesPixeles + numProcesos * sizeof(long long), PROT_READ | PROT_WRITE,
+                        MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (region == MAP_FAILED) {
+        cerr << "No se pudo crear la memoria compartida" << endl;
+        exit(1);
+    }
+    Pixel* compartida = static_cast<Pixel*>(region);
+    long long* tiemposProcesos = reinterpret_cast<long long*>(static_cast<char*>(region) + bytesPixeles);
+    for (size_t j = 0; j < matriz.size(); ++j) {
+        memcpy(&compartida[j * ancho], matriz[j].data(), ancho * sizeof(Pixel));
+    }
+
     for (int i = 0; i < numProcesos; ++i) {
         pid_t pid = fork();
         if (pid == -1) {
             cerr << "Error al crear el proceso" << endl;
             exit(1);
         } else if (pid == 0) { // Proceso hijo
+            auto inicioProceso = chrono::high_resolution_clock::now();
             int inicio = i * tamanoBloque;
             int fin = (i == numProcesos - 1) ? matriz.size() : inicio + tamanoBloque;
             for (int j = inicio; j < fin; ++j) {
-                for (int k = 0; k < matriz[0].size(); ++k) {
-                    umbralizar(matriz[j][k], umbral);
+                for (size_t k = 0; k < ancho; ++k) {
+                    umbralizar(compartida[j * ancho + k], umbral);
                 }
             }
-            guardarMatrizEnBMP(nombreArchivoEscrituraBMP, matriz);
-            exit(0);
+            tiemposProcesos[i] = microsegundosDesde(inicioProceso);
+            _exit(0);
         } else { // Proceso padre
             pids[i] = pid;
         }
@@ -158,10 +203,34 @@ int main(int argc, char* argv[]) {
     int status;
     for (int i = 0; i < numProcesos; ++i) {
         waitpid(pids[i], &status, 0);
-    }   
+    }
+    for (size_t j = 0; j < matriz.size(); ++j) {
+        memcpy(matriz[j].data(), &compartida[j * ancho], ancho * sizeof(Pixel));
+    }
+    vector<long long> tiemposHijos(tiemposProcesos, tiemposProcesos + numProcesos);
+    munmap(region, bytesPixeles + numProcesos * sizeof(long long));
+    long long tiempoUmbralizado = microsegundosDesde(start_time);
+
+    // Guardar la matriz en un nuevo archivo BMP, una sola vez desde el padre
+    inicio = chrono::high_resolution_clock::now();
+    datos = codificarBMP(matriz);
+    long long tiempoCodificacion = microsegundosDesde(inicio);
+
+    inicio = chrono::high_resolution_clock::now();
+    escribirArchivo(nombreArchivoEscrituraBMP, datos);
+    long long tiempoEscritura = microsegundosDesde(inicio);
 
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+    std::cout << "tiempo lectura: " << tiempoLectura << std::endl;
+    std::cout << "tiempo decodificación: " << tiempoDecodificacion << std::endl;
+    std::cout << "tiempo umbralizado: " << tiempoUmbralizado << std::endl;
+    for (int i = 0; i < numProcesos; ++i) {
+        std::cout << "  proceso " << i << ": " << tiemposHijos[i] << std::endl;
+    }
+    std::cout << "tiempo codificación: " << tiempoCodificacion << std::endl;
+    std::cout << "tiempo escritura: " << tiempoEscritura << std::endl;
+    // Igual que antes de separar las fases: umbralizado, codificación y escritura
     std::cout << "tiempo procesos: "<< duracion.count() << std::endl;
 
     return 0;
@@ -1,6 +1,8 @@
 #include <iostream>
 #include <fstream>
 #include <vector>
+#include <cstring>
+#include <chrono>
 #include <omp.h>
 
 using namespace std;
@@ -31,34 +33,48 @@ struct BMPHeader {
 };
 #pragma pack(pop)
 
-vector<vector<Pixel>> leerArchivoBMP(const char* nombreArchivo) {
-    ifstream archivo(nombreArchivo, ios::binary);
+// La lectura del archivo y su decodificación se separan para poder medir cada fase por separado
+vector<char> leerArchivo(const char* nombreArchivo) {
+    ifstream archivo(nombreArchivo, ios::binary | ios::ate);
 
     if (!archivo) {
         cerr << "No se pudo abrir el archivo BMP" << endl;
         exit(1);
     }
 
+    vector<char> datos(archivo.tellg());
+    archivo.seekg(0, ios::beg);
+    archivo.read(datos.data(), datos.size());
+    archivo.close();
+    return datos;
+}
+
+vector<vector<Pixel>> decodificarBMP(const vector<char>& datos) {
     BMPHeader header;
-    archivo.read(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    if (datos.size() < sizeof(BMPHeader)) {
+        cerr << "El archivo BMP está incompleto" << endl;
+        exit(1);
+    }
+    memcpy(&header, datos.data(), sizeof(BMPHeader));
 
     if (header.bitsPerPixel != 24) {
         cerr << "El archivo BMP debe tener 24 bits por píxel" << endl;
         exit(1);
     }
 
-    // Mover el puntero al inicio de los datos de píxeles
-    archivo.seekg(header.dataOffset, ios::beg);
+    // Cada fila ocupa 3 bytes por píxel más el relleno para la alineación de 4 bytes
+    size_t tamanoFila = 3 * header.width + header.width % 4;
+    if (header.dataOffset + tamanoFila * header.height > datos.size()) {
+        cerr << "El archivo BMP está incompleto" << endl;
+        exit(1);
+    }
 
     vector<vector<Pixel>> matriz(header.height, vector<Pixel>(header.width));
 
-    for (int i = 0; i < header.height; ++i) {
-        for (int j = 0; j < header.width; ++j) {
-            archivo.read(reinterpret_cast<char*>(&matriz[i][j]), sizeof(Pixel));
-        }
-        archivo.seekg(header.width % 4, ios::cur);
+    const char* fila = datos.data() + header.dataOffset;
+    for (int i = 0; i < header.height; ++i, fila += tamanoFila) {
+        memcpy(matriz[i].data(), fila, sizeof(Pixel) * header.width);
     }
-    archivo.close();
     return matriz;
 }
 
@@ -71,14 +87,7 @@ void umbralizar(Pixel& pixel, unsigned char umbral) {
     }
 }
 
-void guardarMatrizEnBMP(const char* nombreArchivo, const vector<vector<Pixel>>& matriz) {
-    ofstream archivo(nombreArchivo, ios::binary);
-
-    if (!archivo) {
-        cerr << "No se pudo crear el archivo BMP" << endl;
-        exit(1);
-    }
-
+vector<char> codificarBMP(const vector<vector<Pixel>>& matriz) {
     BMPHeader header;
     header.signature[0] = 'B';
     header.signature[1] = 'M';
@@ -97,22 +106,34 @@ void guardarMatrizEnBMP(const char* nombreArchivo, const vector<vector<Pixel>>&
     header.colors = 0;
     header.importantColors = 0;
 
-    archivo.write(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    // El relleno para la alineación de 4 bytes queda en 0 porque el vector se crea con ceros
+    size_t tamanoFila = 3 * matriz[0].size() + matriz[0].size() % 4;
+    vector<char> datos(sizeof(BMPHeader) + matriz.size() * tamanoFila);
+    memcpy(datos.data(), &header, sizeof(BMPHeader));
 
-    // Escribir la matriz en el archivo BMP
-    for (int i = 0; i < matriz.size(); ++i) {
-        for (int j = 0; j < matriz[0].size(); ++j) {
-            archivo.write(reinterpret_cast<const char*>(&matriz[i][j]), sizeof(Pixel));
-        }
-        // Rellenar con bytes de 0 para la alineación de 4 bytes
-        for (int k = 0; k < matriz[0].size() % 4; ++k) {
-            char paddingByte = 0;
-            archivo.write(&paddingByte, 1);
-        }
+    char* fila = datos.data() + sizeof(BMPHeader);
+    for (size_t i = 0; i < matriz.size(); ++i, fila += tamanoFila) {
+        memcpy(fila, matriz[i].data(), sizeof(Pixel) * matriz[0].size());
+    }
+    return datos;
+}
+
+void escribirArchivo(const char* nombreArchivo, const vector<char>& datos) {
+    ofstream archivo(nombreArchivo, ios::binary);
+
+    if (!archivo) {
+        cerr << "No se pudo crear el archivo BMP" << endl;
+        exit(1);
     }
+
+    archivo.write(datos.data(), datos.size());
     archivo.close();
 }
 
+long long microsegundosDesde(chrono::high_resolution_clock::time_point inicio) {
+    return chrono::duration_cast<chrono::microseconds>(chrono::high_resolution_clock::now() - inicio).count();
+}
+
 int main(int argc, char* argv[]) {
     if (argc != 4) {
         cerr << "Uso: " << argv[0] << " <nombre_del_archivo_entrada.bmp> <nombre_del_archivo_salida.bmp> <umbral>" << endl;
@@ -122,25 +143,53 @@ int main(int argc, char* argv[]) {
     const char* nombreArchivoEscrituraBMP = argv[2];
     unsigned char umbral = static_cast<unsigned char>(stoi(argv[3]));
 
-    // Leer el archivo BMP y obtener la matriz de píxeles
-    vector<vector<Pixel>> matriz = leerArchivoBMP(nombreArchivoLecturaBMP);
+    // Cada fase se mide por separado: lectura del archivo, decodificación, umbralizado, codificación y escritura
+    auto inicio = chrono::high_resolution_clock::now();
+    vector<char> datos = leerArchivo(nombreArchivoLecturaBMP);
+    long long tiempoLectura = microsegundosDesde(inicio);
+
+    inicio = chrono::high_resolution_clock::now();
+    vector<vector<Pixel>> matriz = decodificarBMP(datos);
+    long long tiempoDecodificacion = microsegundosDesde(inicio);
 
     std::cout << std::endl << "MEDICIÓN DE FORMA openMP. .........." << std::endl;
     auto start_time = std::chrono::high_resolution_clock::now();
 
-    // Umbralizar la matriz utilizando OpenMP
-    #pragma omp parallel for collapse(2)
-    for (int i = 0; i < matriz.size(); ++i) {
-        for (int j = 0; j < matriz[0].size(); ++j) {
-            umbralizar(matriz[i][j], umbral);
+    // Umbralizar la matriz utilizando OpenMP; cada hilo mide el tiempo hasta terminar su parte del reparto
+    vector<long long> tiemposHilos(omp_get_max_threads());
+    #pragma omp parallel
+    {
+        auto inicioHilo = chrono::high_resolution_clock::now();
+        #pragma omp for collapse(2) nowait
+        for (int i = 0; i < matriz.size(); ++i) {
+            for (int j = 0; j < matriz[0].size(); ++j) {
+                umbralizar(matriz[i][j], umbral);
+            }
         }
+        tiemposHilos[omp_get_thread_num()] = microsegundosDesde(inicioHilo);
     }
+    long long tiempoUmbralizado = microsegundosDesde(start_time);
 
     // Guardar la matriz en un nuevo archivo BMP
-    guardarMatrizEnBMP(nombreArchivoEscrituraBMP, matriz);
+    inicio = chrono::high_resolution_clock::now();
+    datos = codificarBMP(matriz);
+    long long tiempoCodificacion = microsegundosDesde(inicio);
+
+    inicio = chrono::high_resolution_clock::now();
+    escribirArchivo(nombreArchivoEscrituraBMP, datos);
+    long long tiempoEscritura = microsegundosDesde(inicio);
 
     auto end_time = std::chrono::high_resolution_clock::now();
     auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+    std::cout << "tiempo lectura: " << tiempoLectura << std::endl;
+    std::cout << "tiempo decodificación: " << tiempoDecodificacion << std::endl;
+    std::cout << "tiempo umbralizado: " << tiempoUmbralizado << std::endl;
+    for (size_t i = 0; i < tiemposHilos.size(); ++i) {
+        std::cout << "  hilo " << i << ": " << tiemposHilos[i] << std::endl;
+    }
+    std::cout << "tiempo codificación: " << tiempoCodificacion << std::endl;
+    std::cout << "tiempo escritura: " << tiempoEscritura << std::endl;
+    // Igual que antes de separar las fases: umbralizado, codificación y escritura
     std::cout << "tiempo openMP: "<< duracion.count() << std::endl;
 
     return 0;
@@ -0,0 +1,25 @@
+// Reemplaza los operator new y delete globales para contar las asignaciones (ver memoria.h). Solo va en el ejecutable:
+// en libumbral.so reemplazaría los del programa que la cargue. Las versiones nothrow y de arreglos de la biblioteca
+// estándar llaman a estas, así que también se cuentan.
+
+#include <cstdlib>
+#include <new>
+
+#include "memoria.h"
+
+static void* asignar(size_t bytes) {
+    registrarAsignacion(bytes);
+    void* memoria = std::malloc(bytes == 0 ? 1 : bytes);
+    if (memoria == nullptr) throw std::bad_alloc();
+    return memoria;
+}
+
+void* operator new(size_t bytes) { return asignar(bytes); }
+void* operator new[](size_t bytes) { return asignar(bytes); }
+void operator delete(void* memoria) noexcept { std::free(memoria); }
+void operator delete[](void* memoria) noexcept { std::free(memoria); }
+void operator delete(void* memoria, size_t) noexcept { std::free(memoria); }
+void operator delete[](void* memoria, size_t) noexcept { std::free(memoria); }
+
+// Para que memoria.cpp sepa que las asignaciones se cuentan
+static const bool incluido = (contadorAsignacionesIncluido = true);
@@ -0,0 +1,117 @@
+#include <iostream>
+#include <vector>
+#include <chrono>
+#include <algorithm>
+#include <filesystem>
+
+#include "autotune.h"
+#include "backends.h"
+
+using namespace std;
+
+// Tamaños desde imágenes que caben en la caché L1 hasta imágenes que solo caben en memoria principal
+const int TAMANOS[][2] = {{64, 64}, {256, 256}, {1024, 768}, {2048, 2048}, {4096, 4096}};
+const int FILAS_POR_BLOQUE[] = {0, 1, 8, 64};
+// Una configuración más compleja solo reemplaza a la mejor si es al menos así de rápida, para no elegir por ruido
+const double MEJORA_MINIMA = 0.95;
+
+// Mediana en microsegundos de varias ejecuciones, después de una de calentamiento
+static double medirUs(umbral_backend backend, const TrabajoUmbral& trabajo, int numHilos, int repeticiones) {
+    if (ejecutarBackend(backend, trabajo, numHilos) != UMBRAL_OK) {
+        return -1;
+    }
+    vector<double> tiempos;
+    for (int r = 0; r < repeticiones; ++r) {
+        auto inicio = chrono::steady_clock::now();
+        ejecutarBackend(backend, trabajo, numHilos);
+        auto fin = chrono::steady_clock::now();
+        tiempos.push_back(chrono::duration<double, micro>(fin - inicio).count());
+    }
+    sort(tiempos.begin(), tiempos.end());
+    return tiempos[tiempos.size() / 2];
+}
+
+static vector<int> numerosDeHilos() {
+    vector<int> numeros;
+    int nucleos = nucleosDisponibles();
+    for (int hilos = 2; hilos < nucleos; hilos *= 2) {
+        numeros.push_back(hilos);
+    }
+    numeros.push_back(nucleos);
+    return numeros;
+}
+
+int ejecutarAutotune(const string& rutaPerfil, int repeticiones) {
+    vector<ConfiguracionAjustada> configuraciones;
+    Imagen entrada, salida;
+
+    for (const auto& tamano : TAMANOS) {
+        int ancho = tamano[0], alto = tamano[1];
+        imagenSintetica(entrada, ancho, alto);
+        salida.ancho = ancho;
+        salida.alto = alto;
+        salida.pixeles.resize(entrada.numPixeles());
+
+        // La salida es un buffer aparte para que cada repetición vea la misma imagen de entrada
+        TrabajoUmbral trabajo{bufferDeImagen(entrada), bufferDeImagen(salida), 128};
+        ConfiguracionAjustada mejor{entrada.numPixeles(), UMBRAL_BACKEND_SECUENCIAL, 1, 0, UMBRAL_KERNEL_ESCALAR};
+        double mejorUs = -1;
+        cout << endl << "TAMAÑO " << ancho << "x" << alto << " .........." << endl;
+
+        // Primero el kernel, sin paralelismo que enmascare la diferencia
+        for (umbral_kernel kernel : {UMBRAL_KERNEL_ESCALAR, UMBRAL_KERNEL_TABLA}) {
+            trabajo.kernel = kernel;
+            double us = medirUs(UMBRAL_BACKEND_SECUENCIAL, trabajo, 1, repeticiones);
+            cout << "secuencial kernel=" << nombreKernel(kernel) << ": " << us << endl;
+            if (mejorUs < 0 || us < mejorUs) {
+                mejorUs = us;
+                mejor.kernel = kernel;
+            }
+        }
+
+        // Luego cada backend paralelo con el mejor kernel, variando hilos y filas por bloque
+        trabajo.kernel = mejor.kernel;
+        for (const Backend& backend : backendsRegistrados()) {
+            if (!backend.capacidades.paralelo || !backend.capacidades.disponible) continue;
+            for (int hilos : numerosDeHilos()) {
+                for (int filasPorBloque : FILAS_POR_BLOQUE) {
+                    // El backend de procesos siempre reparte un bloque por proceso
+                    if (backend.capacidades.usaFork && filasPorBloque != 0) continue;
+                    trabajo.filasPorBloque = filasPorBloque;
+                    double us = medirUs(backend.id, trabajo, hilos, repeticiones);
+                    if (us < 0) continue;
+                    cout << backend.nombre << " hilos=" << hilos << " filas_por_bloque=" << filasPorBloque << ": " << us;
+                    // Igual que la selección automática, no se eligen backends que usan fork
+                    if (backend.capacidades.usaFork) {
+                        cout << " (no elegible)" << endl;
+                        continue;
+                    }
+                    cout << endl;
+                    if (us < mejorUs * MEJORA_MINIMA) {
+                        mejorUs = us;
+                        mejor.backend = backend.id;
+                        mejor.hilos = hilos;
+                        mejor.filasPorBloque = filasPorBloque;
+                    }
+                }
+            }
+        }
+        trabajo.filasPorBloque = 0;
+
+        cout << "elegido: " << nombreBackend(mejor.backend) << " hilos=" << mejor.hilos << " filas_por_bloque="
+             << mejor.filasPorBloque << " kernel=" << nombreKernel(mejor.kernel) << " (" << mejorUs << " us)" << endl;
+        configuraciones.push_back(mejor);
+    }
+
+    error_code error;
+    filesystem::path directorio = filesystem::path(rutaPerfil).parent_path();
+    if (!directorio.empty()) {
+        filesystem::create_directories(directorio, error);
+    }
+    if (!guardarPerfil(rutaPerfil, configuraciones)) {
+        cerr << "No se pudo escribir el perfil: " << rutaPerfil << endl;
+        return 1;
+    }
+    cout << endl << "perfil guardado en " << rutaPerfil << endl;
+    return 0;
+}
@@ -0,0 +1,12 @@
+// Comando autotune: mide en esta máquina kernels, backends, número de hilos y filas por bloque sobre imágenes
+// sintéticas de varios tamaños y guarda la combinación más rápida de cada tamaño en un perfil.
+
+#ifndef AUTOTUNE_H
+#define AUTOTUNE_H
+
+#include <string>
+
+// Devuelve 0 si el perfil se pudo escribir
+int ejecutarAutotune(const std::string& rutaPerfil, int repeticiones);
+
+#endif
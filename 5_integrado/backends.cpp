@@ -0,0 +1,421 @@
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <optional>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#include "backends.h"
+#include "traza.h"
+
+using namespace std;
+
+// Tiempo y, si se pidieron, contadores de hardware de la parte que umbraliza un hilo o proceso. Se crea en el hilo que
+// hace el trabajo porque los contadores son por hilo.
+class MedicionParte {
+public:
+    // Los contadores se construyen en el lugar, sin pedir memoria, para que se pueda usar en un hijo de fork; ahí van sin
+    // anotarErrores
+    explicit MedicionParte(bool conContadores, bool anotarErrores = true) {
+        if (conContadores) {
+            contadores.emplace(anotarErrores);
+            contadores->iniciar();
+        }
+        inicio = chrono::steady_clock::now();
+    }
+
+    void terminar(double* tiempo, LecturaContadores* lectura) {
+        if (tiempo != nullptr) *tiempo = microsegundosDesde(inicio);
+        if (lectura != nullptr && contadores) *lectura = contadores->detener();
+    }
+
+private:
+    optional<ContadoresHardware> contadores;
+    chrono::steady_clock::time_point inicio;
+};
+
+// Deja lugar para las mediciones de partes hilos o procesos
+static void prepararMediciones(const TrabajoUmbral& trabajo, int partes) {
+    if (trabajo.tiemposHilos != nullptr) trabajo.tiemposHilos->assign(partes, 0);
+    if (trabajo.contadoresHilos != nullptr) trabajo.contadoresHilos->assign(partes, LecturaContadores());
+}
+
+static double* tiempoParte(const TrabajoUmbral& trabajo, int k) {
+    return trabajo.tiemposHilos != nullptr ? &(*trabajo.tiemposHilos)[k] : nullptr;
+}
+
+static LecturaContadores* contadoresParte(const TrabajoUmbral& trabajo, int k) {
+    return trabajo.contadoresHilos != nullptr ? &(*trabajo.contadoresHilos)[k] : nullptr;
+}
+
+// Umbraliza un bloque de filas y lo registra en la traza, si está activa
+static void umbralizarBloque(const TrabajoUmbral& trabajo, int inicio, int fin) {
+    IntervaloTraza intervalo("bloque", "umbralizado", "filas", fin - inicio);
+    umbralizarFilas(trabajo, inicio, fin);
+}
+
+static int backendSecuencial(const TrabajoUmbral& trabajo, int, PoolHilos*) {
+    prepararMediciones(trabajo, 1);
+    MedicionParte medicion(trabajo.contadoresHilos != nullptr);
+    umbralizarBloque(trabajo, 0, trabajo.entrada.alto);
+    medicion.terminar(tiempoParte(trabajo, 0), contadoresParte(trabajo, 0));
+    return UMBRAL_OK;
+}
+
+// Sin filasPorBloque, divide las filas en bloques de aproximadamente el mismo tamaño, uno por hilo del pool. Con
+// filasPorBloque, cada hilo toma bloques de ese tamaño de un contador compartido hasta que no quedan, lo que compensa
+// hilos más lentos o interrumpidos a cambio de una operación atómica por bloque. Con el pool del modo por lotes se usan
+// numHilos de sus hilos (los del perfil ajustado, con el backend automático), sin pasar de los que tiene.
+static int backendHilos(const TrabajoUmbral& trabajo, int numHilos, PoolHilos* pool) {
+    PoolHilos& hilos = pool != nullptr ? *pool : poolCompartido(numHilos);
+    int alto = trabajo.entrada.alto;
+    int numBloques = min(min(hilos.tamano(), numHilos), alto);
+    // Cada tarea escribe solo su propia posición de las mediciones
+    prepararMediciones(trabajo, numBloques);
+    if (trabajo.filasPorBloque > 0) {
+        atomic<int> siguiente(0);
+        hilos.ejecutarEnParalelo(numBloques, [&](int k) {
+            MedicionParte medicion(trabajo.contadoresHilos != nullptr);
+            int inicio;
+            while ((inicio = siguiente.fetch_add(trabajo.filasPorBloque)) < alto) {
+                umbralizarBloque(trabajo, inicio, min(alto, inicio + trabajo.filasPorBloque));
+            }
+            medicion.terminar(tiempoParte(trabajo, k), contadoresParte(trabajo, k));
+        });
+        return UMBRAL_OK;
+    }
+    int tamanoBloque = alto / numBloques;
+    hilos.ejecutarEnParalelo(numBloques, [&](int k) {
+        MedicionParte medicion(trabajo.contadoresHilos != nullptr);
+        int inicio = k * tamanoBloque;
+        int fin = (k == numBloques - 1) ? alto : inicio + tamanoBloque;
+        umbralizarBloque(trabajo, inicio, fin);
+        medicion.terminar(tiempoParte(trabajo, k), contadoresParte(trabajo, k));
+    });
+    return UMBRAL_OK;
+}
+
+// Cada proceso hijo escribe su bloque en una región compartida (MAP_SHARED); la memoria normal del hijo es una copia
+// y sus cambios no llegarían al padre. Al final el padre copia la región a la salida. El tiempo de cada hijo va en la
+// misma región, después de los píxeles, junto con sus contadores y su intervalo de la traza.
+static int backendProcesos(const TrabajoUmbral& trabajo, int numProcesos, PoolHilos*) {
+    int alto = trabajo.entrada.alto;
+    numProcesos = min(numProcesos, alto);
+    size_t bytesFila = static_cast<size_t>(trabajo.salida.ancho) * bytesPorPixel(trabajo.salida.formato);
+    // Las mediciones empiezan en una posición alineada aunque los píxeles ocupen un número impar de bytes
+    size_t bytesPixeles = (bytesFila * alto + 63) / 64 * 64;
+    size_t bytesTiempos = numProcesos * sizeof(double);
+    size_t bytesContadores = numProcesos * sizeof(LecturaContadores);
+    size_t tamano = bytesPixeles + bytesTiempos + bytesContadores + numProcesos * sizeof(EventoTraza);
+    void* compartida = mmap(nullptr, tamano, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_ANONYMOUS, -1, 0);
+    if (compartida == MAP_FAILED) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+
+    TrabajoUmbral trabajoHijo = trabajo;
+    trabajoHijo.salida.datos = compartida;
+    trabajoHijo.salida.paso = bytesFila;
+
+    double* tiemposHijos = reinterpret_cast<double*>(static_cast<unsigned char*>(compartida) + bytesPixeles);
+    LecturaContadores* contadoresHijos =
+        reinterpret_cast<LecturaContadores*>(static_cast<unsigned char*>(compartida) + bytesPixeles + bytesTiempos);
+    EventoTraza* eventosHijos = reinterpret_cast<EventoTraza*>(static_cast<unsigned char*>(compartida) + bytesPixeles +
+                                                               bytesTiempos + bytesContadores);
+    int tamanoBloque = alto / numProcesos;
+    vector<pid_t> pids;
+    bool error = false;
+    for (int i = 0; i < numProcesos; ++i) {
+        pid_t pid = fork();
+        if (pid == -1) {
+            error = true;
+            break;
+        } else if (pid == 0) { // Proceso hijo
+            MedicionParte medicion(trabajo.contadoresHilos != nullptr, false);
+            int inicio = i * tamanoBloque;
+            int fin = (i == numProcesos - 1) ? alto : inicio + tamanoBloque;
+            IntervaloTraza intervalo("bloque", "umbralizado", "filas", fin - inicio);
+            umbralizarFilas(trabajoHijo, inicio, fin);
+            eventosHijos[i] = intervalo.tomar();
+            medicion.terminar(&tiemposHijos[i], &contadoresHijos[i]);
+            _exit(0);
+        } else { // Proceso padre
+            pids.push_back(pid);
+        }
+    }
+
+    // Esperar a que todos los procesos hijos terminen
+    for (pid_t pid : pids) {
+        int status;
+        if (waitpid(pid, &status, 0) == -1 || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            error = true;
+        }
+    }
+
+    if (!error) {
+        for (int i = 0; i < alto; ++i) {
+            memcpy(filaBuffer(trabajo.salida, i), static_cast<unsigned char*>(compartida) + i * bytesFila, bytesFila);
+        }
+        if (trabajo.tiemposHilos != nullptr) trabajo.tiemposHilos->assign(tiemposHijos, tiemposHijos + numProcesos);
+        if (trabajo.contadoresHilos != nullptr) {
+            trabajo.contadoresHilos->assign(contadoresHijos, contadoresHijos + numProcesos);
+            for (int i = 0; i < numProcesos; ++i) anotarErroresContadores(contadoresHijos[i]);
+        }
+        if (trazaActivada()) {
+            for (int i = 0; i < numProcesos; ++i) agregarEventoTraza(eventosHijos[i]);
+        }
+    }
+    munmap(compartida, tamano);
+    return error ? UMBRAL_ERROR_SISTEMA : UMBRAL_OK;
+}
+
+// Se reparte por bloques de filas (y no fila por fila) para que cada bloque prepare su tabla una sola vez
+static int backendOpenMP(const TrabajoUmbral& trabajo, int numHilos, PoolHilos*) {
+#ifdef _OPENMP
+    int alto = trabajo.entrada.alto;
+    int filasPorBloque = trabajo.filasPorBloque > 0 ? trabajo.filasPorBloque : (alto + numHilos - 1) / numHilos;
+    int numBloques = (alto + filasPorBloque - 1) / filasPorBloque;
+    prepararMediciones(trabajo, numHilos);
+    #pragma omp parallel num_threads(numHilos)
+    {
+        MedicionParte medicion(trabajo.contadoresHilos != nullptr);
+        #pragma omp for schedule(dynamic) nowait
+        for (int k = 0; k < numBloques; ++k) {
+            umbralizarBloque(trabajo, k * filasPorBloque, min(alto, (k + 1) * filasPorBloque));
+        }
+        int hilo = omp_get_thread_num();
+        medicion.terminar(tiempoParte(trabajo, hilo), contadoresParte(trabajo, hilo));
+    }
+    return UMBRAL_OK;
+#else
+    (void)trabajo;
+    (void)numHilos;
+    return UMBRAL_ERROR_BACKEND;
+#endif
+}
+
+#ifdef _OPENMP
+const bool OPENMP_DISPONIBLE = true;
+#else
+const bool OPENMP_DISPONIBLE = false;
+#endif
+
+// Los modelos de costo por defecto son aproximados: lo que importa es el orden entre backends, sobre todo en imágenes
+// pequeñas, donde crear procesos o repartir entre hilos cuesta más que umbralizar.
+static vector<Backend> backendsIncluidos() {
+    return {
+        {UMBRAL_BACKEND_SECUENCIAL, "secuencial", {false, true, false, false}, {0.5, 0, 0.35, 0}, backendSecuencial},
+        {UMBRAL_BACKEND_HILOS, "hilos", {true, true, false, false}, {5, 2, 0.35, 0}, backendHilos},
+        {UMBRAL_BACKEND_PROCESOS, "procesos", {true, true, true, true}, {50, 80, 0.35, 0.1}, backendProcesos},
+        {UMBRAL_BACKEND_OPENMP, "openmp", {true, OPENMP_DISPONIBLE, false, false}, {3, 1, 0.35, 0}, backendOpenMP},
+    };
+}
+
+static mutex mtxRegistro;
+
+static vector<Backend>& registro() {
+    static vector<Backend> backends = backendsIncluidos();
+    return backends;
+}
+
+void registrarBackend(const Backend& backend) {
+    lock_guard<mutex> lock(mtxRegistro);
+    for (Backend& existente : registro()) {
+        if (existente.id == backend.id) {
+            existente = backend;
+            return;
+        }
+    }
+    registro().push_back(backend);
+}
+
+vector<Backend> backendsRegistrados() {
+    lock_guard<mutex> lock(mtxRegistro);
+    return registro();
+}
+
+bool buscarBackend(umbral_backend id, Backend& backend) {
+    lock_guard<mutex> lock(mtxRegistro);
+    for (const Backend& existente : registro()) {
+        if (existente.id == id) {
+            backend = existente;
+            return true;
+        }
+    }
+    return false;
+}
+
+size_t memoriaDisponible() {
+    ifstream meminfo("/proc/meminfo");
+    string linea;
+    while (getline(meminfo, linea)) {
+        if (linea.rfind("MemAvailable:", 0) == 0) {
+            istringstream campos(linea.substr(13));
+            size_t kilobytes = 0;
+            campos >> kilobytes;
+            return kilobytes * 1024;
+        }
+    }
+    return static_cast<size_t>(sysconf(_SC_AVPHYS_PAGES)) * sysconf(_SC_PAGESIZE);
+}
+
+PerfilTrabajo perfilDe(const TrabajoUmbral& trabajo, int numHilos) {
+    PerfilTrabajo perfil;
+    perfil.pixeles = static_cast<size_t>(trabajo.entrada.ancho) * trabajo.entrada.alto;
+    perfil.bytesEntrada = bytesPorPixel(trabajo.entrada.formato);
+    perfil.bytesSalida = bytesPorPixel(trabajo.salida.formato);
+    perfil.numHilos = min(numHilos > 0 ? numHilos : nucleosDisponibles(), trabajo.entrada.alto);
+    perfil.nucleos = nucleosDisponibles();
+    // Leer /proc/meminfo cuesta más que umbralizar una imagen pequeña; se consulta solo si algún backend lo necesita
+    perfil.memoriaDisponible = 0;
+    return perfil;
+}
+
+double estimarCostoUs(const Backend& backend, const PerfilTrabajo& perfil) {
+    int hilos = backend.capacidades.paralelo ? perfil.numHilos : 1;
+    // Más hilos que núcleos no aceleran, pero sí cuestan crearlos o despertarlos
+    int paralelismo = min(hilos, perfil.nucleos);
+    double bytes = static_cast<double>(perfil.pixeles) * (perfil.bytesEntrada + perfil.bytesSalida);
+    double bytesSalida = static_cast<double>(perfil.pixeles) * perfil.bytesSalida;
+    return backend.costo.fijoUs + backend.costo.porHiloUs * hilos +
+           (bytes * backend.costo.nsPorByte / paralelismo + bytesSalida * backend.costo.nsPorByteSerie) / 1000;
+}
+
+umbral_backend elegirBackend(const TrabajoUmbral& trabajo, int numHilos) {
+    PerfilTrabajo perfil = perfilDe(trabajo, numHilos);
+    umbral_backend mejor = UMBRAL_BACKEND_SECUENCIAL;
+    double mejorCosto = -1;
+    for (const Backend& backend : backendsRegistrados()) {
+        if (!backend.capacidades.disponible || backend.capacidades.usaFork) continue;
+        // El buffer auxiliar no debe ocupar más de la mitad de la memoria libre
+        if (backend.capacidades.bufferAuxiliar) {
+            if (perfil.memoriaDisponible == 0) perfil.memoriaDisponible = memoriaDisponible();
+            if (perfil.pixeles * perfil.bytesSalida > perfil.memoriaDisponible / 2) continue;
+        }
+        double costo = estimarCostoUs(backend, perfil);
+        if (mejorCosto < 0 || costo < mejorCosto) {
+            mejor = backend.id;
+            mejorCosto = costo;
+        }
+    }
+    return mejor;
+}
+
+static mutex mtxPerfil;
+static vector<ConfiguracionAjustada> perfilCargado;
+
+string rutaPerfilPorDefecto() {
+    if (const char* ruta = getenv("UMBRALIZAR_PERFIL")) return ruta;
+    if (const char* configuracion = getenv("XDG_CONFIG_HOME")) return string(configuracion) + "/umbralizar/perfil.txt";
+    if (const char* inicio = getenv("HOME")) return string(inicio) + "/.config/umbralizar/perfil.txt";
+    return "perfil.txt";
+}
+
+// Formato: una línea "<pixeles> <backend> <hilos> <filas_por_bloque> <kernel>" por tamaño medido; # inicia comentario
+bool cargarPerfil(const string& ruta) {
+    ifstream archivo(ruta);
+    if (!archivo) {
+        return false;
+    }
+    vector<ConfiguracionAjustada> configuraciones;
+    string linea;
+    while (getline(archivo, linea)) {
+        size_t comentario = linea.find('#');
+        if (comentario != string::npos) linea.erase(comentario);
+        istringstream campos(linea);
+        ConfiguracionAjustada configuracion;
+        string backend, kernel;
+        if (!(campos >> configuracion.pixeles)) continue;
+        if (!(campos >> backend >> configuracion.hilos >> configuracion.filasPorBloque >> kernel) ||
+            !backendPorNombre(backend, configuracion.backend) || configuracion.backend == UMBRAL_BACKEND_AUTO ||
+            !kernelPorNombre(kernel, configuracion.kernel) || configuracion.hilos <= 0 || configuracion.filasPorBloque < 0) {
+            return false;
+        }
+        configuraciones.push_back(configuracion);
+    }
+    lock_guard<mutex> lock(mtxPerfil);
+    perfilCargado = configuraciones;
+    return true;
+}
+
+bool guardarPerfil(const string& ruta, const vector<ConfiguracionAjustada>& configuraciones) {
+    ofstream archivo(ruta);
+    if (!archivo) {
+        return false;
+    }
+    archivo << "# Perfil de umbralizar generado por autotune en una máquina con " << nucleosDisponibles() << " núcleos" << endl;
+    archivo << "# pixeles backend hilos filas_por_bloque kernel" << endl;
+    for (const ConfiguracionAjustada& configuracion : configuraciones) {
+        archivo << configuracion.pixeles << " " << nombreBackend(configuracion.backend) << " " << configuracion.hilos << " "
+                << configuracion.filasPorBloque << " " << nombreKernel(configuracion.kernel) << endl;
+    }
+    return static_cast<bool>(archivo);
+}
+
+umbral_backend resolverAuto(TrabajoUmbral& trabajo, int& numHilos) {
+    double pixeles = static_cast<double>(trabajo.entrada.ancho) * trabajo.entrada.alto;
+    {
+        lock_guard<mutex> lock(mtxPerfil);
+        const ConfiguracionAjustada* cercana = nullptr;
+        // El tamaño más cercano en escala logarítmica, porque los tamaños medidos crecen de forma geométrica
+        for (const ConfiguracionAjustada& configuracion : perfilCargado) {
+            if (cercana == nullptr || fabs(log(pixeles / configuracion.pixeles)) < fabs(log(pixeles / cercana->pixeles))) {
+                cercana = &configuracion;
+            }
+        }
+        if (cercana != nullptr) {
+            Backend backend;
+            if (buscarBackend(cercana->backend, backend) && backend.capacidades.disponible) {
+                trabajo.kernel = cercana->kernel;
+                trabajo.filasPorBloque = cercana->filasPorBloque;
+                numHilos = cercana->hilos;
+                return cercana->backend;
+            }
+        }
+    }
+    return elegirBackend(trabajo, numHilos);
+}
+
+int ejecutarBackend(umbral_backend id, const TrabajoUmbral& trabajo, int numHilos, PoolHilos* pool) {
+    if (numHilos <= 0) numHilos = nucleosDisponibles();
+    TrabajoUmbral resuelto = trabajo;
+    if (id == UMBRAL_BACKEND_AUTO) {
+        id = resolverAuto(resuelto, numHilos);
+    }
+    Backend backend;
+    if (!buscarBackend(id, backend) || !backend.capacidades.disponible) {
+        return UMBRAL_ERROR_BACKEND;
+    }
+    return backend.ejecutar(resuelto, numHilos, pool);
+}
+
+const char* nombreBackend(umbral_backend id) {
+    if (id == UMBRAL_BACKEND_AUTO) return "auto";
+    lock_guard<mutex> lock(mtxRegistro);
+    for (const Backend& backend : registro()) {
+        if (backend.id == id) return backend.nombre;
+    }
+    return "desconocido";
+}
+
+bool backendPorNombre(const string& nombre, umbral_backend& id) {
+    if (nombre == "auto") {
+        id = UMBRAL_BACKEND_AUTO;
+        return true;
+    }
+    lock_guard<mutex> lock(mtxRegistro);
+    for (const Backend& backend : registro()) {
+        if (nombre == backend.nombre) {
+            id = backend.id;
+            return true;
+        }
+    }
+    return false;
+}
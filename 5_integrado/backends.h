@@ -0,0 +1,82 @@
+// Registro de backends. Cada backend declara lo que puede hacer y un modelo de costo; con UMBRAL_BACKEND_AUTO se elige
+// el de menor costo estimado para el tamaño y formato de la imagen, los núcleos y la memoria libre de la máquina.
+
+#ifndef BACKENDS_H
+#define BACKENDS_H
+
+#include <string>
+#include <vector>
+
+#include "nucleo.h"
+
+struct CapacidadesBackend {
+    bool paralelo;        // reparte las filas entre varios hilos o procesos
+    bool disponible;      // false si no está en esta compilación (OpenMP sin -fopenmp)
+    bool usaFork;         // crea procesos; la selección automática no lo usa porque no es seguro con otros hilos
+    bool bufferAuxiliar;  // necesita memoria adicional del tamaño de la salida
+};
+
+// Lo que el modelo de costo sabe de un trabajo antes de ejecutarlo
+struct PerfilTrabajo {
+    size_t pixeles;
+    int bytesEntrada;
+    int bytesSalida;
+    int numHilos;
+    int nucleos;
+    size_t memoriaDisponible; // 0 mientras no se haya consultado
+};
+
+// Tiempo estimado = fijo + porHilo * hilos + bytes movidos * nsPorByte / paralelismo efectivo
+//                  + bytes de salida * nsPorByteSerie (copias que no se reparten, como la del backend de procesos)
+struct ModeloCosto {
+    double fijoUs;
+    double porHiloUs;
+    double nsPorByte;
+    double nsPorByteSerie;
+};
+
+struct Backend {
+    umbral_backend id;
+    const char* nombre;
+    CapacidadesBackend capacidades;
+    ModeloCosto costo;
+    int (*ejecutar)(const TrabajoUmbral& trabajo, int numHilos, PoolHilos* pool);
+};
+
+// Agrega un backend (o reemplaza el que tenga el mismo id)
+void registrarBackend(const Backend& backend);
+std::vector<Backend> backendsRegistrados();
+bool buscarBackend(umbral_backend id, Backend& backend);
+
+double estimarCostoUs(const Backend& backend, const PerfilTrabajo& perfil);
+PerfilTrabajo perfilDe(const TrabajoUmbral& trabajo, int numHilos);
+size_t memoriaDisponible();
+
+// Backend con menor costo estimado entre los disponibles que sirven para el trabajo
+umbral_backend elegirBackend(const TrabajoUmbral& trabajo, int numHilos);
+
+// Configuración que autotune midió como la más rápida para imágenes de alrededor de "pixeles" píxeles
+struct ConfiguracionAjustada {
+    size_t pixeles;
+    umbral_backend backend;
+    int hilos;
+    int filasPorBloque;
+    umbral_kernel kernel;
+};
+
+std::string rutaPerfilPorDefecto();
+bool cargarPerfil(const std::string& ruta);
+bool guardarPerfil(const std::string& ruta, const std::vector<ConfiguracionAjustada>& configuraciones);
+
+// Resuelve UMBRAL_BACKEND_AUTO: con un perfil cargado usa la configuración medida para el tamaño más cercano
+// (backend, hilos, kernel y filas por bloque); sin perfil, el modelo de costo.
+umbral_backend resolverAuto(TrabajoUmbral& trabajo, int& numHilos);
+
+// Umbraliza con el backend indicado (o el elegido, si es UMBRAL_BACKEND_AUTO). Si pool es nulo, el backend de hilos
+// usa el pool compartido.
+int ejecutarBackend(umbral_backend backend, const TrabajoUmbral& trabajo, int numHilos, PoolHilos* pool = nullptr);
+
+const char* nombreBackend(umbral_backend backend);
+bool backendPorNombre(const std::string& nombre, umbral_backend& backend);
+
+#endif
@@ -0,0 +1,64 @@
+#include <iostream>
+#include <chrono>
+
+#include "bench.h"
+#include "backends.h"
+#include "medicion.h"
+
+using namespace std;
+
+int ejecutarBench(const OpcionesBench& opciones) {
+    ostream& informe = salidaInforme(opciones.formato, opciones.salida);
+    TablaResultados tabla({"backend", "kernel", "hilos", "ancho", "alto", "repeticiones", "min_us", "mediana_us",
+                           "p95_us", "media_us", "desviacion_us", "mb_s", "mpx_s"});
+
+    informe << endl << "MEDICIÓN DE FORMA BENCH. .........." << endl;
+    Imagen entrada, salida;
+    int fallos = 0;
+    for (const auto& tamano : opciones.tamanos) {
+        imagenSintetica(entrada, tamano.first, tamano.second);
+        salida.ancho = entrada.ancho;
+        salida.alto = entrada.alto;
+        salida.pixeles.resize(entrada.numPixeles());
+        // Bytes leídos y escritos por ejecución, para el ancho de banda efectivo
+        double bytes = 2.0 * entrada.numPixeles() * sizeof(Pixel);
+
+        for (const Backend& backend : backendsRegistrados()) {
+            if (!backend.capacidades.disponible) continue;
+            int numHilos = backend.capacidades.paralelo ? opciones.numHilos : 1;
+            for (umbral_kernel kernel : {UMBRAL_KERNEL_ESCALAR, UMBRAL_KERNEL_TABLA}) {
+                // La salida es aparte para que todas las repeticiones vean la misma entrada (el kernel escalar tiene
+                // un salto que depende de los datos)
+                TrabajoUmbral trabajo{bufferDeImagen(entrada), bufferDeImagen(salida), 128, kernel};
+                bool correcto = true;
+                for (int r = 0; r < opciones.calentamiento && correcto; ++r) {
+                    correcto = ejecutarBackend(backend.id, trabajo, numHilos) == UMBRAL_OK;
+                }
+                vector<double> tiempos;
+                for (int r = 0; r < opciones.repeticiones && correcto; ++r) {
+                    auto inicio = chrono::steady_clock::now();
+                    correcto = ejecutarBackend(backend.id, trabajo, numHilos) == UMBRAL_OK;
+                    auto fin = chrono::steady_clock::now();
+                    tiempos.push_back(chrono::duration<double, micro>(fin - inicio).count());
+                }
+                if (!correcto) {
+                    cerr << "Falló el backend " << backend.nombre << " con " << entrada.ancho << "x" << entrada.alto << endl;
+                    ++fallos;
+                    continue;
+                }
+
+                Estadisticas e = calcularEstadisticas(tiempos);
+                double mbPorSegundo = bytes / e.mediana;  // bytes por microsegundo = MB/s
+                double mpxPorSegundo = entrada.numPixeles() / e.mediana;
+                tabla.agregar({backend.nombre, nombreKernel(kernel), numHilos, entrada.ancho, entrada.alto, e.muestras,
+                               e.minimo, e.mediana, e.p95, e.media, e.desviacion, mbPorSegundo, mpxPorSegundo});
+                informe << entrada.ancho << "x" << entrada.alto << " " << backend.nombre << " kernel=" << nombreKernel(kernel)
+                        << " hilos=" << numHilos << ": mediana " << e.mediana << " us, p95 " << e.p95 << " us, "
+                        << mbPorSegundo << " MB/s, " << mpxPorSegundo << " Mpx/s" << endl;
+            }
+        }
+    }
+
+    if (!tabla.escribirResultados(opciones.formato, opciones.salida)) return 1;
+    return fallos == 0 ? 0 : 1;
+}
@@ -0,0 +1,22 @@
+// Comando bench: mide cada backend con cada kernel sobre imágenes sintéticas de varios tamaños, con repeticiones de
+// calentamiento, y resume los tiempos (mínimo, mediana, p95, desviación) y el rendimiento en MB/s y píxeles/s.
+
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <string>
+#include <vector>
+#include <utility>
+
+struct OpcionesBench {
+    std::vector<std::pair<int, int>> tamanos;
+    int repeticiones;
+    int calentamiento;
+    int numHilos;
+    std::string formato; // "csv" o "json"; vacío para solo el resumen legible
+    std::string salida;  // archivo para el formato elegido; vacío para la salida estándar
+};
+
+int ejecutarBench(const OpcionesBench& opciones);
+
+#endif
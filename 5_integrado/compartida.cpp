@@ -0,0 +1,86 @@
+#include <cstring>
+#include <cerrno>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <unistd.h>
+
+#include "compartida.h"
+#include "nucleo.h"
+
+using namespace std;
+
+// Los sockets son SOCK_SEQPACKET: cada mensaje llega entero o no llega, así que no hace falta reconstruirlo por partes
+const int MAX_DESCRIPTORES = 2;
+
+bool enviarConDescriptores(int conexion, const void* datos, size_t n, const int* descriptores, int numDescriptores) {
+    if (numDescriptores > MAX_DESCRIPTORES) return false;
+    iovec vector{const_cast<void*>(datos), n};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_DESCRIPTORES)];
+    msghdr mensaje{};
+    mensaje.msg_iov = &vector;
+    mensaje.msg_iovlen = 1;
+    if (numDescriptores > 0) {
+        memset(control, 0, sizeof(control));
+        mensaje.msg_control = control;
+        mensaje.msg_controllen = CMSG_SPACE(sizeof(int) * numDescriptores);
+        cmsghdr* cabecera = CMSG_FIRSTHDR(&mensaje);
+        cabecera->cmsg_level = SOL_SOCKET;
+        cabecera->cmsg_type = SCM_RIGHTS;
+        cabecera->cmsg_len = CMSG_LEN(sizeof(int) * numDescriptores);
+        memcpy(CMSG_DATA(cabecera), descriptores, sizeof(int) * numDescriptores);
+    }
+    ssize_t enviados;
+    do {
+        enviados = sendmsg(conexion, &mensaje, MSG_NOSIGNAL);
+    } while (enviados < 0 && errno == EINTR);
+    return enviados == static_cast<ssize_t>(n);
+}
+
+bool recibirConDescriptores(int conexion, void* datos, size_t n, int* descriptores, int maxDescriptores,
+                            int& numDescriptores) {
+    numDescriptores = 0;
+    iovec vector{datos, n};
+    alignas(cmsghdr) char control[CMSG_SPACE(sizeof(int) * MAX_DESCRIPTORES)];
+    msghdr mensaje{};
+    mensaje.msg_iov = &vector;
+    mensaje.msg_iovlen = 1;
+    mensaje.msg_control = control;
+    mensaje.msg_controllen = sizeof(control);
+    ssize_t recibidos;
+    do {
+        recibidos = recvmsg(conexion, &mensaje, MSG_CMSG_CLOEXEC);
+    } while (recibidos < 0 && errno == EINTR);
+
+    // Los descriptores recibidos se toman siempre, aunque el mensaje sea inválido, para poder cerrarlos
+    for (cmsghdr* cabecera = CMSG_FIRSTHDR(&mensaje); cabecera != nullptr; cabecera = CMSG_NXTHDR(&mensaje, cabecera)) {
+        if (cabecera->cmsg_level != SOL_SOCKET || cabecera->cmsg_type != SCM_RIGHTS) continue;
+        int cantidad = (cabecera->cmsg_len - CMSG_LEN(0)) / sizeof(int);
+        const unsigned char* origen = CMSG_DATA(cabecera);
+        for (int i = 0; i < cantidad; ++i) {
+            int descriptor;
+            memcpy(&descriptor, origen + i * sizeof(int), sizeof(int));
+            if (numDescriptores < maxDescriptores) {
+                descriptores[numDescriptores++] = descriptor;
+            } else {
+                close(descriptor);
+            }
+        }
+    }
+    if (recibidos != static_cast<ssize_t>(n) || (mensaje.msg_flags & (MSG_TRUNC | MSG_CTRUNC))) {
+        for (int i = 0; i < numDescriptores; ++i) close(descriptores[i]);
+        numDescriptores = 0;
+        return false;
+    }
+    return true;
+}
+
+bool segmentoCabe(const SegmentoMensaje& segmento, size_t tamano) {
+    if (segmento.ancho <= 0 || segmento.alto <= 0 || segmento.formato < UMBRAL_FORMATO_BGR24 ||
+        segmento.formato > UMBRAL_FORMATO_GRIS8) {
+        return false;
+    }
+    uint64_t bytesFila = static_cast<uint64_t>(segmento.ancho) * bytesPorPixel(static_cast<umbral_formato>(segmento.formato));
+    if (segmento.paso <= 0 || static_cast<uint64_t>(segmento.paso) < bytesFila) return false;
+    uint64_t necesario = static_cast<uint64_t>(segmento.paso) * (segmento.alto - 1) + bytesFila;
+    return segmento.desplazamiento <= tamano && necesario <= tamano - segmento.desplazamiento;
+}
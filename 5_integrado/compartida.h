@@ -0,0 +1,49 @@
+// Entrega de imágenes en memoria compartida: un proceso productor deja la imagen en un segmento (memfd_create o
+// shm_open) y pasa el descriptor por un socket Unix (SCM_RIGHTS). El servidor mapea el mismo segmento y escribe el
+// resultado en un segundo segmento, sin copiar los píxeles ni pasar por archivos. Lo usan el modo "servidor" de
+// umbralizar y las funciones umbral_conectar/umbral_enviar de la biblioteca.
+
+#ifndef COMPARTIDA_H
+#define COMPARTIDA_H
+
+#include <cstddef>
+#include <cstdint>
+
+#include "umbral.h"
+
+// Ubicación de una imagen dentro de un segmento; el descriptor viaja aparte, como dato auxiliar del mensaje
+struct SegmentoMensaje {
+    uint64_t desplazamiento;
+    int32_t ancho;
+    int32_t alto;
+    int64_t paso;
+    int32_t formato;
+};
+
+// Mensaje fijo que envía el cliente junto con dos descriptores: entrada y salida (pueden ser el mismo segmento)
+struct MensajeTrabajo {
+    SegmentoMensaje entrada;
+    SegmentoMensaje salida;
+    char metodo[16]; // número entre 0 y 255, "otsu" o "media"
+    int32_t backend;
+    int32_t hilos;
+    int32_t kernel;
+    int32_t filasPorBloque;
+};
+
+struct RespuestaTrabajo {
+    int32_t estado;
+    uint8_t umbral; // el umbral usado, útil cuando se pidió un método automático
+};
+
+// Envía n bytes en un solo mensaje con numDescriptores descriptores adjuntos
+bool enviarConDescriptores(int conexion, const void* datos, size_t n, const int* descriptores, int numDescriptores);
+
+// Recibe exactamente n bytes y hasta maxDescriptores descriptores. Devuelve false si la conexión se cerró o falló.
+bool recibirConDescriptores(int conexion, void* datos, size_t n, int* descriptores, int maxDescriptores,
+                            int& numDescriptores);
+
+// Comprueba que la imagen descrita cabe en un segmento de tamano bytes; el paso tiene que ser positivo
+bool segmentoCabe(const SegmentoMensaje& segmento, size_t tamano);
+
+#endif
@@ -0,0 +1,151 @@
+#include <cstring>
+#include <cerrno>
+#include <mutex>
+#include <sstream>
+#include <unistd.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <linux/perf_event.h>
+
+#include "contadores.h"
+
+using namespace std;
+
+static mutex mtxError;
+static string primerError;
+
+static void anotarError(const char* contador, int error) {
+    lock_guard<mutex> lock(mtxError);
+    if (primerError.empty()) primerError = string(contador) + ": " + strerror(error);
+}
+
+string errorContadores() {
+    lock_guard<mutex> lock(mtxError);
+    return primerError;
+}
+
+struct DescripcionContador {
+    const char* nombre;
+    uint32_t tipo;
+    uint64_t configuracion;
+};
+
+static const DescripcionContador CONTADORES[NUM_CONTADORES] = {
+    {"ciclos", PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES},
+    {"instrucciones", PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS},
+    {"fallos LLC", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                       (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"fallos dTLB", PERF_TYPE_HW_CACHE, PERF_COUNT_HW_CACHE_DTLB | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                                        (PERF_COUNT_HW_CACHE_RESULT_MISS << 16)},
+    {"saltos fallidos", PERF_TYPE_HARDWARE, PERF_COUNT_HW_BRANCH_MISSES},
+};
+
+void anotarErroresContadores(const LecturaContadores& lectura) {
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        if (lectura.errores[c] != 0) anotarError(CONTADORES[c].nombre, lectura.errores[c]);
+    }
+}
+
+ContadoresHardware::ContadoresHardware(bool anotarErrores) {
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        perf_event_attr atributos;
+        memset(&atributos, 0, sizeof(atributos));
+        atributos.size = sizeof(atributos);
+        atributos.type = CONTADORES[c].tipo;
+        atributos.config = CONTADORES[c].configuracion;
+        atributos.disabled = 1;
+        atributos.exclude_kernel = 1;
+        atributos.exclude_hv = 1;
+        // Si hay más contadores abiertos que registros en la PMU, el núcleo los turna; con estos tiempos se escala
+        atributos.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+        descriptores[c] = syscall(SYS_perf_event_open, &atributos, 0, -1, -1, PERF_FLAG_FD_CLOEXEC);
+        if (descriptores[c] != -1) continue;
+        if (anotarErrores) {
+            anotarError(CONTADORES[c].nombre, errno);
+        } else {
+            errores[c] = errno;
+        }
+    }
+}
+
+ContadoresHardware::~ContadoresHardware() {
+    for (int descriptor : descriptores) {
+        if (descriptor != -1) close(descriptor);
+    }
+}
+
+bool ContadoresHardware::algunoDisponible() const {
+    for (int descriptor : descriptores) {
+        if (descriptor != -1) return true;
+    }
+    return false;
+}
+
+void ContadoresHardware::iniciar() {
+    for (int descriptor : descriptores) {
+        if (descriptor == -1) continue;
+        ioctl(descriptor, PERF_EVENT_IOC_RESET, 0);
+        ioctl(descriptor, PERF_EVENT_IOC_ENABLE, 0);
+    }
+}
+
+LecturaContadores ContadoresHardware::detener() {
+    LecturaContadores lectura;
+    memcpy(lectura.errores, errores, sizeof(errores));
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        if (descriptores[c] != -1) ioctl(descriptores[c], PERF_EVENT_IOC_DISABLE, 0);
+    }
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        uint64_t datos[3]; // valor, tiempo habilitado, tiempo contando
+        if (descriptores[c] == -1 || read(descriptores[c], datos, sizeof(datos)) != sizeof(datos)) continue;
+        // Un contador que nunca llegó a estar en la PMU no dice nada, aunque se haya podido abrir
+        if (datos[2] == 0) continue;
+        lectura.valores[c] = datos[2] < datos[1] ? static_cast<uint64_t>(static_cast<double>(datos[0]) * datos[1] / datos[2])
+                                                 : datos[0];
+        lectura.disponibles[c] = true;
+    }
+    return lectura;
+}
+
+double LecturaContadores::ipc() const {
+    if (!disponible(CONTADOR_CICLOS) || !disponible(CONTADOR_INSTRUCCIONES) || valores[CONTADOR_CICLOS] == 0) return 0;
+    return static_cast<double>(valores[CONTADOR_INSTRUCCIONES]) / valores[CONTADOR_CICLOS];
+}
+
+LecturaContadores& LecturaContadores::operator+=(const LecturaContadores& otra) {
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        if (!otra.disponibles[c]) continue;
+        valores[c] += otra.valores[c];
+        disponibles[c] = true;
+    }
+    return *this;
+}
+
+string resumenContadores(const LecturaContadores& lectura, size_t pixeles) {
+    ostringstream salida;
+    for (int c = 0; c < NUM_CONTADORES; ++c) {
+        if (c > 0) salida << ", ";
+        salida << CONTADORES[c].nombre << " ";
+        if (lectura.disponibles[c]) {
+            salida << lectura.valores[c];
+        } else {
+            salida << "n/d";
+        }
+    }
+    salida << ", IPC ";
+    if (lectura.ipc() > 0) {
+        salida << lectura.ipc();
+    } else {
+        salida << "n/d";
+    }
+    // Los fallos por píxel son los que indican si el trabajo está limitado por la memoria
+    for (ContadorHardware c : {CONTADOR_FALLOS_LLC, CONTADOR_FALLOS_DTLB, CONTADOR_SALTOS_FALLIDOS}) {
+        salida << ", " << CONTADORES[c].nombre << "/píxel ";
+        if (lectura.disponible(c) && pixeles > 0) {
+            salida << static_cast<double>(lectura.valores[c]) / pixeles;
+        } else {
+            salida << "n/d";
+        }
+    }
+    return salida.str();
+}
@@ -0,0 +1,67 @@
+// Contadores de hardware del hilo que llama, leídos con perf_event_open: ciclos, instrucciones, fallos de la caché de
+// último nivel (LLC), fallos del dTLB y saltos mal predichos. Con el IPC y los fallos por píxel se ve si un backend está
+// limitado por el cómputo (IPC alto), por la latencia de memoria (IPC bajo con pocos fallos de LLC) o por el ancho de
+// banda (muchos fallos de LLC por píxel) sin tener que correr un profiler aparte.
+//
+// Cada contador se abre por separado: si el núcleo no permite alguno (perf_event_paranoid, máquinas virtuales sin PMU)
+// ese queda marcado como no disponible y los demás siguen funcionando. Solo se cuenta el espacio de usuario.
+
+#ifndef CONTADORES_H
+#define CONTADORES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+enum ContadorHardware {
+    CONTADOR_CICLOS,
+    CONTADOR_INSTRUCCIONES,
+    CONTADOR_FALLOS_LLC,
+    CONTADOR_FALLOS_DTLB,
+    CONTADOR_SALTOS_FALLIDOS,
+    NUM_CONTADORES
+};
+
+// Sin punteros ni memoria dinámica, para que un proceso hijo la pueda dejar en memoria compartida
+struct LecturaContadores {
+    uint64_t valores[NUM_CONTADORES] = {};
+    bool disponibles[NUM_CONTADORES] = {};
+    // El errno de perf_event_open de los contadores que no se pudieron abrir sin anotar el error (en un hijo de fork)
+    int errores[NUM_CONTADORES] = {};
+
+    bool disponible(ContadorHardware contador) const { return disponibles[contador]; }
+    // Instrucciones por ciclo; 0 si falta alguno de los dos
+    double ipc() const;
+    // Suma los contadores disponibles en las dos lecturas
+    LecturaContadores& operator+=(const LecturaContadores& otra);
+};
+
+class ContadoresHardware {
+public:
+    // Abre los contadores del hilo actual, detenidos. Un hijo de fork no puede anotar los errores (toma un mutex que otro
+    // hilo del padre podía tener tomado y crea un string): sin anotarErrores quedan en la lectura para que los anote
+    // el padre con anotarErroresContadores.
+    explicit ContadoresHardware(bool anotarErrores = true);
+    ~ContadoresHardware();
+    ContadoresHardware(const ContadoresHardware&) = delete;
+    ContadoresHardware& operator=(const ContadoresHardware&) = delete;
+
+    bool algunoDisponible() const;
+    // Pone los contadores en 0 y empieza a contar
+    void iniciar();
+    // Deja de contar y devuelve lo contado desde iniciar
+    LecturaContadores detener();
+
+private:
+    int descriptores[NUM_CONTADORES];
+    int errores[NUM_CONTADORES] = {};
+};
+
+// El motivo por el que no se pudo abrir el primer contador que falló en este proceso, o "" si no falló ninguno
+std::string errorContadores();
+void anotarErroresContadores(const LecturaContadores& lectura);
+
+// Una línea con los contadores, el IPC y los fallos por píxel; "n/d" en los que no están disponibles
+std::string resumenContadores(const LecturaContadores& lectura, size_t pixeles);
+
+#endif
@@ -0,0 +1,75 @@
+#include <iostream>
+#include <chrono>
+
+#include "escalado.h"
+#include "backends.h"
+#include "medicion.h"
+
+using namespace std;
+
+// Tiempos de repeticiones ejecuciones después de las de calentamiento; vacío si alguna falló
+static vector<double> medir(umbral_backend backend, const TrabajoUmbral& trabajo, int numHilos, int calentamiento,
+                            int repeticiones) {
+    vector<double> tiempos;
+    for (int r = 0; r < calentamiento; ++r) {
+        if (ejecutarBackend(backend, trabajo, numHilos) != UMBRAL_OK) return {};
+    }
+    for (int r = 0; r < repeticiones; ++r) {
+        auto inicio = chrono::steady_clock::now();
+        if (ejecutarBackend(backend, trabajo, numHilos) != UMBRAL_OK) return {};
+        auto fin = chrono::steady_clock::now();
+        tiempos.push_back(chrono::duration<double, micro>(fin - inicio).count());
+    }
+    return tiempos;
+}
+
+int ejecutarEscalado(const OpcionesEscalado& opciones) {
+    ostream& informe = salidaInforme(opciones.formato, opciones.salida);
+    TablaResultados tabla({"tipo", "backend", "kernel", "hilos", "ancho", "alto", "mediana_us", "p95_us",
+                           "aceleracion", "eficiencia", "mpx_s"});
+
+    informe << endl << "MEDICIÓN DE FORMA ESCALADO. .........." << endl;
+    Imagen entrada, salida;
+    int fallos = 0;
+    for (const Backend& backend : backendsRegistrados()) {
+        if (!backend.capacidades.disponible || !backend.capacidades.paralelo) continue;
+        for (bool debil : {false, true}) {
+            const char* tipo = debil ? "debil" : "fuerte";
+            double tiempoUnHilo = 0;
+            for (int numHilos = 1; numHilos <= opciones.maxHilos; ++numHilos) {
+                // En el fuerte la imagen se genera una sola vez; en el débil crece con los hilos
+                if (debil || numHilos == 1) {
+                    int ancho = debil ? opciones.tamanoPorHilo.first : opciones.tamanoFuerte.first;
+                    int alto = debil ? opciones.tamanoPorHilo.second * numHilos : opciones.tamanoFuerte.second;
+                    imagenSintetica(entrada, ancho, alto);
+                    salida.ancho = ancho;
+                    salida.alto = alto;
+                    salida.pixeles.resize(entrada.numPixeles());
+                }
+                TrabajoUmbral trabajo{bufferDeImagen(entrada), bufferDeImagen(salida), 128, opciones.kernel};
+                vector<double> tiempos = medir(backend.id, trabajo, numHilos, opciones.calentamiento, opciones.repeticiones);
+                if (tiempos.empty()) {
+                    cerr << "Falló el backend " << backend.nombre << " con " << numHilos << " hilos" << endl;
+                    ++fallos;
+                    break;
+                }
+
+                Estadisticas e = calcularEstadisticas(tiempos);
+                if (numHilos == 1) tiempoUnHilo = e.mediana;
+                // En el débil cada hilo tiene el mismo trabajo, así que lo ideal es que el tiempo no cambie: la
+                // eficiencia es t1 / tn y la aceleración (escalada) n veces eso
+                double eficiencia = debil ? tiempoUnHilo / e.mediana : tiempoUnHilo / e.mediana / numHilos;
+                double aceleracion = debil ? eficiencia * numHilos : tiempoUnHilo / e.mediana;
+                double mpxPorSegundo = entrada.numPixeles() / e.mediana;
+                tabla.agregar({tipo, backend.nombre, nombreKernel(opciones.kernel), numHilos, entrada.ancho, entrada.alto,
+                               e.mediana, e.p95, aceleracion, eficiencia, mpxPorSegundo});
+                informe << tipo << " " << backend.nombre << " hilos=" << numHilos << " " << entrada.ancho << "x"
+                        << entrada.alto << ": mediana " << e.mediana << " us, aceleración " << aceleracion
+                        << ", eficiencia " << 100 * eficiencia << "%" << endl;
+            }
+        }
+    }
+
+    if (!tabla.escribirResultados(opciones.formato, opciones.salida)) return 1;
+    return fallos == 0 ? 0 : 1;
+}
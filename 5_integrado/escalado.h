@@ -0,0 +1,26 @@
+// Comando escalado: mide cada backend paralelo con 1 a N hilos. En el escalado fuerte la imagen es siempre la misma; en
+// el débil crece con los hilos (la misma cantidad de filas por hilo). Para cada cantidad de hilos informa la aceleración
+// y la eficiencia respecto del mismo backend con un hilo.
+
+#ifndef ESCALADO_H
+#define ESCALADO_H
+
+#include <string>
+#include <utility>
+
+#include "umbral.h"
+
+struct OpcionesEscalado {
+    int maxHilos;
+    std::pair<int, int> tamanoFuerte;  // imagen del escalado fuerte
+    std::pair<int, int> tamanoPorHilo; // en el débil, la imagen con n hilos es de ancho x (alto * n)
+    int repeticiones;
+    int calentamiento;
+    umbral_kernel kernel;
+    std::string formato; // "csv" o "json"; vacío para solo el resumen legible
+    std::string salida;  // archivo para el formato elegido; vacío para la salida estándar
+};
+
+int ejecutarEscalado(const OpcionesEscalado& opciones);
+
+#endif
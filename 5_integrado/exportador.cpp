@@ -0,0 +1,142 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <chrono>
+#include <cstdio>
+#include <numeric>
+
+#include "exportador.h"
+
+using namespace std;
+
+// Límites de los histogramas, en segundos: desde una imagen chica en la caché hasta una de gigapíxeles en disco
+const double LIMITES_SEGUNDOS[] = {0.0001, 0.00025, 0.0005, 0.001, 0.0025, 0.005, 0.01, 0.025,
+                                   0.05,   0.1,     0.25,   0.5,   1,      2.5,   5,    10};
+const size_t NUM_LIMITES = sizeof(LIMITES_SEGUNDOS) / sizeof(LIMITES_SEGUNDOS[0]);
+
+ExportadorMetricas::ExportadorMetricas(const string& ruta, double intervaloSegundos, int hilos)
+    : ruta(ruta), hilos(hilos) {
+    auto intervalo = chrono::duration<double>(intervaloSegundos);
+    escritor = thread([this, intervalo] {
+        unique_lock<mutex> lock(mtx);
+        while (!terminar) {
+            lock.unlock();
+            escribir();
+            lock.lock();
+            despertar.wait_for(lock, intervalo, [this] { return terminar; });
+        }
+    });
+}
+
+void ExportadorMetricas::detener() {
+    {
+        lock_guard<mutex> lock(mtx);
+        if (terminar) return;
+        terminar = true;
+    }
+    despertar.notify_one();
+    escritor.join();
+    escribir();
+}
+
+void ExportadorMetricas::trabajosRecibidos(int cantidad) {
+    lock_guard<mutex> lock(mtx);
+    pendientes += cantidad;
+}
+
+void ExportadorMetricas::trabajoTerminado(bool correcto, uint64_t entrada, uint64_t salida, double ocupado) {
+    lock_guard<mutex> lock(mtx);
+    ++(correcto ? trabajosCorrectos : trabajosFallidos);
+    bytesEntrada += entrada;
+    bytesSalida += salida;
+    ocupadoSegundos += ocupado;
+    --pendientes;
+}
+
+void ExportadorMetricas::observarFase(const string& fase, double segundos) {
+    lock_guard<mutex> lock(mtx);
+    Histograma& histograma = fases[fase];
+    if (histograma.cuentas.empty()) histograma.cuentas.assign(NUM_LIMITES, 0);
+    size_t k = 0;
+    while (k < NUM_LIMITES && segundos > LIMITES_SEGUNDOS[k]) ++k;
+    // Las que superan el último límite solo cuentan en +Inf, que es el total
+    if (k < NUM_LIMITES) ++histograma.cuentas[k];
+    histograma.suma += segundos;
+    ++histograma.total;
+}
+
+void ExportadorMetricas::trabajoTerminado(const MedicionTrabajo& medicion) {
+    const TiemposFases& t = medicion.tiempos;
+    if (medicion.correcto) {
+        observarFase("lectura", t.lectura / 1e6);
+        observarFase("decodificacion", t.decodificacion / 1e6);
+        observarFase("umbralizado", t.umbralizado / 1e6);
+        observarFase("codificacion", t.codificacion / 1e6);
+        observarFase("escritura", t.escritura / 1e6);
+    }
+    observarFase("total", medicion.totalUs / 1e6);
+    // Los píxeles leídos y los escritos, sin encabezado ni relleno
+    uint64_t bytes = static_cast<uint64_t>(medicion.ancho) * medicion.alto * sizeof(Pixel);
+    trabajoTerminado(medicion.correcto, bytes, bytes, accumulate(t.hilos.begin(), t.hilos.end(), 0.0) / 1e6);
+}
+
+bool ExportadorMetricas::escribir() {
+    ostringstream texto;
+    texto.precision(12);
+    {
+        lock_guard<mutex> lock(mtx);
+        texto << "# HELP umbralizar_trabajos_total Imágenes procesadas, por resultado.\n"
+              << "# TYPE umbralizar_trabajos_total counter\n"
+              << "umbralizar_trabajos_total{resultado=\"correcto\"} " << trabajosCorrectos << "\n"
+              << "umbralizar_trabajos_total{resultado=\"error\"} " << trabajosFallidos << "\n"
+              << "# HELP umbralizar_bytes_entrada_total Bytes de píxeles leídos.\n"
+              << "# TYPE umbralizar_bytes_entrada_total counter\n"
+              << "umbralizar_bytes_entrada_total " << bytesEntrada << "\n"
+              << "# HELP umbralizar_bytes_salida_total Bytes de píxeles escritos.\n"
+              << "# TYPE umbralizar_bytes_salida_total counter\n"
+              << "umbralizar_bytes_salida_total " << bytesSalida << "\n"
+              << "# HELP umbralizar_trabajos_pendientes Trabajos recibidos o en la cola que todavía no terminaron.\n"
+              << "# TYPE umbralizar_trabajos_pendientes gauge\n"
+              << "umbralizar_trabajos_pendientes " << pendientes << "\n"
+              << "# HELP umbralizar_hilos Hilos que pueden umbralizar a la vez.\n"
+              << "# TYPE umbralizar_hilos gauge\n"
+              << "umbralizar_hilos " << hilos << "\n"
+              << "# HELP umbralizar_hilos_ocupados_segundos_total Tiempo de los hilos umbralizando, sumado entre todos; "
+              << "la utilización es su tasa dividida por umbralizar_hilos.\n"
+              << "# TYPE umbralizar_hilos_ocupados_segundos_total counter\n"
+              << "umbralizar_hilos_ocupados_segundos_total " << ocupadoSegundos << "\n"
+              << "# HELP umbralizar_fase_segundos Duración de cada fase de un trabajo.\n"
+              << "# TYPE umbralizar_fase_segundos histogram\n";
+        for (const auto& fase : fases) {
+            uint64_t acumulado = 0;
+            for (size_t k = 0; k < NUM_LIMITES; ++k) {
+                acumulado += fase.second.cuentas[k];
+                texto << "umbralizar_fase_segundos_bucket{fase=\"" << fase.first << "\",le=\"" << LIMITES_SEGUNDOS[k]
+                      << "\"} " << acumulado << "\n";
+            }
+            texto << "umbralizar_fase_segundos_bucket{fase=\"" << fase.first << "\",le=\"+Inf\"} " << fase.second.total
+                  << "\n"
+                  << "umbralizar_fase_segundos_sum{fase=\"" << fase.first << "\"} " << fase.second.suma << "\n"
+                  << "umbralizar_fase_segundos_count{fase=\"" << fase.first << "\"} " << fase.second.total << "\n";
+        }
+    }
+    auto ahora = chrono::duration<double>(chrono::system_clock::now().time_since_epoch()).count();
+    texto << "# HELP umbralizar_ultima_escritura_segundos Hora de esta escritura (segundos desde 1970).\n"
+          << "# TYPE umbralizar_ultima_escritura_segundos gauge\n"
+          << "umbralizar_ultima_escritura_segundos " << static_cast<long long>(ahora) << "\n";
+
+    string temporal = ruta + ".tmp";
+    {
+        ofstream archivo(temporal);
+        archivo << texto.str();
+        if (!archivo) {
+            cerr << "No se pudieron escribir las métricas en " << temporal << endl;
+            return false;
+        }
+    }
+    if (rename(temporal.c_str(), ruta.c_str()) != 0) {
+        cerr << "No se pudo reemplazar " << ruta << endl;
+        return false;
+    }
+    return true;
+}
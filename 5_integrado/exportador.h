@@ -0,0 +1,64 @@
+// Métricas para Prometheus de los modos que corren mucho tiempo (servidor y lote): trabajos por resultado, bytes de
+// entrada y salida, histogramas de la duración de cada fase, trabajos pendientes y tiempo de los hilos umbralizando. Se
+// escriben en el formato de texto de Prometheus en un archivo que se reemplaza cada tanto (primero se escribe uno
+// temporal y después se renombra, así quien lo lea nunca ve uno a medias), como lo lee el "textfile collector" de
+// node_exporter. Para alertar si el proceso se colgó está la hora de la última escritura.
+
+#ifndef EXPORTADOR_H
+#define EXPORTADOR_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <map>
+#include <mutex>
+#include <thread>
+#include <condition_variable>
+
+#include "lote.h"
+
+class ExportadorMetricas {
+public:
+    // hilos es la cantidad de hilos que pueden umbralizar a la vez, para calcular la utilización
+    ExportadorMetricas(const std::string& ruta, double intervaloSegundos, int hilos);
+    ~ExportadorMetricas() { detener(); }
+    ExportadorMetricas(const ExportadorMetricas&) = delete;
+    ExportadorMetricas& operator=(const ExportadorMetricas&) = delete;
+
+    void trabajosRecibidos(int cantidad);
+    // ocupadoSegundos es lo que pasaron los hilos umbralizando, sumado entre todos
+    void trabajoTerminado(bool correcto, uint64_t bytesEntrada, uint64_t bytesSalida, double ocupadoSegundos);
+    void observarFase(const std::string& fase, double segundos);
+    // Lo anterior con lo medido de una imagen del modo por lotes
+    void trabajoTerminado(const MedicionTrabajo& medicion);
+
+    // Deja de reescribir el archivo y lo escribe una última vez. Lo que se registre después queda solo en memoria.
+    void detener();
+
+private:
+    // Solo desde el hilo escritor o, después de terminarlo, desde el destructor
+    bool escribir();
+
+    struct Histograma {
+        std::vector<uint64_t> cuentas; // una por límite, sin acumular
+        double suma = 0;
+        uint64_t total = 0;
+    };
+
+    std::string ruta;
+    int hilos;
+    std::mutex mtx;
+    uint64_t trabajosCorrectos = 0;
+    uint64_t trabajosFallidos = 0;
+    uint64_t bytesEntrada = 0;
+    uint64_t bytesSalida = 0;
+    long long pendientes = 0;
+    double ocupadoSegundos = 0;
+    std::map<std::string, Histograma> fases;
+
+    bool terminar = false;
+    std::condition_variable despertar;
+    std::thread escritor;
+};
+
+#endif
@@ -0,0 +1,189 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+
+#include "generador.h"
+
+using namespace std;
+
+// Cada tanda ocupa alrededor de esto; basta para que las escrituras sean grandes sin ocupar mucha memoria
+const size_t BYTES_POR_TANDA = 8 << 20;
+
+// Alto de cada renglón del patrón de texto y ancho de cada letra; las letras son de 5x7 con un margen alrededor
+const int ALTO_RENGLON = 12;
+const int ANCHO_LETRA = 8;
+
+bool patronPorNombre(const string& nombre, PatronSintetico& patron) {
+    if (nombre == "degradado") {
+        patron = PATRON_DEGRADADO;
+    } else if (nombre == "ruido") {
+        patron = PATRON_RUIDO;
+    } else if (nombre == "texto") {
+        patron = PATRON_TEXTO;
+    } else if (nombre == "mixto") {
+        patron = PATRON_MIXTO;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+// splitmix64: convierte la semilla y una posición en un valor que no se parece al de las posiciones vecinas
+static uint64_t mezclar(uint64_t x) {
+    x += 0x9E3779B97F4A7C15ULL;
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    return x ^ (x >> 31);
+}
+
+static unsigned char saturar(int valor) {
+    return static_cast<unsigned char>(min(255, max(0, valor)));
+}
+
+static void filaDegradado(const OpcionesGenerador& opciones, int i, Pixel* fila, int amplitudRuido) {
+    uint64_t estado = mezclar((static_cast<uint64_t>(opciones.semilla) << 32) ^ static_cast<uint32_t>(i));
+    long long diagonal = max(1LL, static_cast<long long>(opciones.ancho) + opciones.alto - 2);
+    for (int j = 0; j < opciones.ancho; ++j) {
+        int base = static_cast<int>(255 * (static_cast<long long>(i) + j) / diagonal);
+        int ruido = 0;
+        if (amplitudRuido > 0) {
+            estado = estado * 6364136223846793005ULL + 1442695040888963407ULL;
+            ruido = static_cast<int>(estado >> 58) * amplitudRuido / 32 - amplitudRuido;
+        }
+        fila[j].blue = saturar(base + ruido);
+        fila[j].green = saturar(base - ruido);
+        fila[j].red = saturar(base + ruido / 2);
+    }
+}
+
+static void filaRuido(const OpcionesGenerador& opciones, int i, Pixel* fila) {
+    uint64_t estado = mezclar((static_cast<uint64_t>(opciones.semilla) << 32) ^ static_cast<uint32_t>(i) ^ 0x5A5A5A5AULL);
+    for (int j = 0; j < opciones.ancho; ++j) {
+        estado = estado * 6364136223846793005ULL + 1442695040888963407ULL;
+        fila[j].blue = static_cast<unsigned char>(estado >> 56);
+        fila[j].green = static_cast<unsigned char>(estado >> 48);
+        fila[j].red = static_cast<unsigned char>(estado >> 40);
+    }
+}
+
+// Cada letra es un mapa de 5x7 bits que sale de mezclar la semilla con el renglón y la columna; una de cada ocho es un
+// espacio
+static void filaTexto(const OpcionesGenerador& opciones, int i, Pixel* fila) {
+    int renglon = i / ALTO_RENGLON;
+    int y = i % ALTO_RENGLON - 3;
+    const Pixel fondo{220, 225, 230};
+    const Pixel tinta{40, 30, 25};
+    for (int j = 0; j < opciones.ancho; ++j) {
+        fila[j] = fondo;
+    }
+    if (y < 0 || y >= 7) return;
+    for (int inicio = 0; inicio < opciones.ancho; inicio += ANCHO_LETRA) {
+        uint64_t letra = mezclar((static_cast<uint64_t>(opciones.semilla) << 40) ^
+                                 (static_cast<uint64_t>(renglon) << 24) ^ static_cast<uint64_t>(inicio / ANCHO_LETRA));
+        if ((letra >> 61) == 0) continue;
+        for (int x = 0; x < 5 && inicio + 1 + x < opciones.ancho; ++x) {
+            if ((letra >> (y * 5 + x)) & 1) fila[inicio + 1 + x] = tinta;
+        }
+    }
+}
+
+void generarFila(const OpcionesGenerador& opciones, int i, Pixel* fila) {
+    PatronSintetico patron = opciones.patron;
+    if (patron == PATRON_MIXTO) {
+        // Tres franjas del mismo alto: degradado con ruido, texto y ruido
+        static const PatronSintetico franjas[3] = {PATRON_DEGRADADO, PATRON_TEXTO, PATRON_RUIDO};
+        patron = franjas[min(2LL, 3LL * i / max(1, opciones.alto))];
+        if (patron == PATRON_DEGRADADO) {
+            filaDegradado(opciones, i, fila, 32);
+            return;
+        }
+    }
+    switch (patron) {
+    case PATRON_DEGRADADO:
+        filaDegradado(opciones, i, fila, 0);
+        break;
+    case PATRON_RUIDO:
+        filaRuido(opciones, i, fila);
+        break;
+    default:
+        filaTexto(opciones, i, fila);
+        break;
+    }
+}
+
+// Pasa una fila BGR24 al formato crudo pedido
+static void convertirFila(const Pixel* fila, unsigned char* destino, int ancho, umbral_formato formato) {
+    const unsigned char* origen = reinterpret_cast<const unsigned char*>(fila);
+    switch (formato) {
+    case UMBRAL_FORMATO_GRIS8:
+        convertirFilaAGris(origen, destino, ancho, sizeof(Pixel));
+        break;
+    case UMBRAL_FORMATO_RGB24:
+        for (int j = 0; j < ancho; ++j) {
+            destino[3 * j] = fila[j].red;
+            destino[3 * j + 1] = fila[j].green;
+            destino[3 * j + 2] = fila[j].blue;
+        }
+        break;
+    case UMBRAL_FORMATO_BGRA32:
+        for (int j = 0; j < ancho; ++j) {
+            destino[4 * j] = fila[j].blue;
+            destino[4 * j + 1] = fila[j].green;
+            destino[4 * j + 2] = fila[j].red;
+            destino[4 * j + 3] = 255;
+        }
+        break;
+    default:
+        copy(origen, origen + sizeof(Pixel) * ancho, destino);
+        break;
+    }
+}
+
+bool generarImagen(const string& ruta, const OpcionesGenerador& opciones) {
+    ofstream archivo;
+    if (ruta != "-") {
+        archivo.open(ruta, ios::binary);
+        if (!archivo) {
+            cerr << "No se pudo crear el archivo: " << ruta << endl;
+            return false;
+        }
+    }
+    ostream& salida = ruta == "-" ? cout : archivo;
+
+    int ancho = opciones.ancho;
+    size_t bytesFila = opciones.crudo ? static_cast<size_t>(ancho) * bytesPorPixel(opciones.formato)
+                                      : 3 * static_cast<size_t>(ancho) + ancho % 4;
+    if (!opciones.crudo) {
+        BMPHeader header = encabezadoBMP(ancho, opciones.alto);
+        salida.write(reinterpret_cast<const char*>(&header), sizeof(BMPHeader));
+    }
+
+    int filasPorTanda = static_cast<int>(max<size_t>(1, min<size_t>(opciones.alto, BYTES_POR_TANDA / bytesFila)));
+    vector<Pixel> pixeles(static_cast<size_t>(filasPorTanda) * ancho);
+    // El relleno de cada fila del BMP queda en 0 porque nunca se escribe
+    vector<unsigned char> tanda(filasPorTanda * bytesFila, 0);
+    int numPartes = min(opciones.numHilos, filasPorTanda);
+    for (int inicio = 0; inicio < opciones.alto && salida; inicio += filasPorTanda) {
+        int filas = min(filasPorTanda, opciones.alto - inicio);
+        auto parte = [&](int k) {
+            for (int r = filas * k / numPartes; r < filas * (k + 1) / numPartes; ++r) {
+                Pixel* fila = &pixeles[static_cast<size_t>(r) * ancho];
+                generarFila(opciones, inicio + r, fila);
+                convertirFila(fila, &tanda[r * bytesFila], ancho, opciones.crudo ? opciones.formato : UMBRAL_FORMATO_BGR24);
+            }
+        };
+        if (numPartes == 1) {
+            parte(0);
+        } else {
+            poolCompartido(numPartes).ejecutarEnParalelo(numPartes, parte);
+        }
+        salida.write(reinterpret_cast<const char*>(tanda.data()), filas * bytesFila);
+    }
+
+    salida.flush();
+    if (!salida) {
+        cerr << "Error al escribir " << ruta << endl;
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,41 @@
+// Generador de imágenes de prueba de cualquier tamaño, para medir desde imágenes que entran en la caché hasta otras que
+// solo entran en disco. Las filas se generan por tandas y se escriben a medida que salen, así que nunca hay más de una
+// tanda en memoria. Cada fila depende solo de la semilla y de su número, así que el resultado es el mismo con cualquier
+// cantidad de hilos.
+
+#ifndef GENERADOR_H
+#define GENERADOR_H
+
+#include <cstdint>
+#include <string>
+
+#include "nucleo.h"
+
+enum PatronSintetico {
+    PATRON_DEGRADADO, // degradado diagonal
+    PATRON_RUIDO,     // cada canal al azar
+    PATRON_TEXTO,     // renglones de "letras" oscuras sobre fondo claro, con bordes nítidos
+    PATRON_MIXTO      // franjas horizontales de los tres anteriores, el degradado con algo de ruido
+};
+
+bool patronPorNombre(const std::string& nombre, PatronSintetico& patron);
+
+struct OpcionesGenerador {
+    int ancho;
+    int alto;
+    PatronSintetico patron = PATRON_MIXTO;
+    uint32_t semilla = 1;
+    // Sin crudo se escribe un BMP de 24 bits; con crudo, las mismas filas en el mismo orden pero en formato, sin
+    // encabezado ni relleno (como las lee el modo video)
+    bool crudo = false;
+    umbral_formato formato = UMBRAL_FORMATO_BGR24;
+    int numHilos = 1;
+};
+
+// La fila i en el orden del BMP (la 0 es la de abajo)
+void generarFila(const OpcionesGenerador& opciones, int i, Pixel* fila);
+
+// ruta puede ser "-" para la salida estándar
+bool generarImagen(const std::string& ruta, const OpcionesGenerador& opciones);
+
+#endif
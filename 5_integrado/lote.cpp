@@ -0,0 +1,296 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <memory>
+
+#include "lote.h"
+#include "traza.h"
+
+using namespace std;
+
+// La cache usa la fecha de modificación de cada archivo como marca del último uso, para conservar el orden entre
+// ejecuciones
+CacheResultados::CacheResultados(const string& directorio, uintmax_t tamanoMaximo)
+    : directorio(directorio), tamanoMaximo(tamanoMaximo) {
+    error_code error;
+    filesystem::create_directories(directorio, error);
+
+    struct Existente {
+        Entrada entrada;
+        filesystem::file_time_type ultimoUso;
+    };
+    vector<Existente> existentes;
+    for (const auto& archivo : filesystem::directory_iterator(directorio, error)) {
+        string nombre = archivo.path().stem().string();
+        if (archivo.path().extension() != ".bmp" || nombre.size() != 16) continue;
+        char* fin;
+        uint64_t clave = strtoull(nombre.c_str(), &fin, 16);
+        if (*fin != '\0') continue;
+        Existente existente{{clave, archivo.file_size(error)}, archivo.last_write_time(error)};
+        if (error) continue;
+        existentes.push_back(existente);
+    }
+    sort(existentes.begin(), existentes.end(),
+         [](const Existente& a, const Existente& b) { return a.ultimoUso > b.ultimoUso; });
+    lock_guard<mutex> lock(mtx);
+    for (const Existente& existente : existentes) {
+        usos.push_back(existente.entrada);
+        entradas[existente.entrada.clave] = prev(usos.end());
+        total += existente.entrada.tamano;
+    }
+    expulsar();
+}
+
+uint64_t CacheResultados::clave(uint64_t hashPixeles, const Imagen& imagen, const string& metodo) {
+    // Los umbrales numéricos se normalizan como los interpreta resolverUmbral, así "080" y "80" comparten la entrada
+    string umbral = metodo == "otsu" || metodo == "media" ? metodo : to_string(stoi(metodo));
+    string parametros = to_string(imagen.ancho) + "x" + to_string(imagen.alto) + ":" + umbral;
+    return hashBytes(parametros.data(), parametros.size(), hashPixeles);
+}
+
+bool CacheResultados::recuperar(uint64_t clave, const string& salida) {
+    filesystem::path entrada = ruta(clave);
+    error_code error;
+    filesystem::copy_file(entrada, salida, filesystem::copy_options::overwrite_existing, error);
+    if (error) {
+        return false;
+    }
+    filesystem::last_write_time(entrada, filesystem::file_time_type::clock::now(), error);
+    lock_guard<mutex> lock(mtx);
+    auto existente = entradas.find(clave);
+    if (existente != entradas.end()) {
+        usos.splice(usos.begin(), usos, existente->second);
+    }
+    return true;
+}
+
+void CacheResultados::guardar(uint64_t clave, const string& salida) {
+    // Se copia a un temporal y se renombra para que otro hilo nunca vea una entrada a medio escribir
+    filesystem::path destino = ruta(clave);
+    filesystem::path temporal = destino;
+    temporal += ".tmp" + to_string(hash<thread::id>()(this_thread::get_id()));
+    error_code error;
+    filesystem::copy_file(salida, temporal, filesystem::copy_options::overwrite_existing, error);
+    uintmax_t tamano = error ? 0 : filesystem::file_size(temporal, error);
+    if (!error) {
+        filesystem::rename(temporal, destino, error);
+    }
+    if (error) {
+        filesystem::remove(temporal, error);
+        return;
+    }
+    lock_guard<mutex> lock(mtx);
+    usar(clave, tamano);
+    expulsar();
+}
+
+filesystem::path CacheResultados::ruta(uint64_t clave) const {
+    char nombre[24];
+    snprintf(nombre, sizeof(nombre), "%016llx.bmp", static_cast<unsigned long long>(clave));
+    return filesystem::path(directorio) / nombre;
+}
+
+void CacheResultados::usar(uint64_t clave, uintmax_t tamano) {
+    auto existente = entradas.find(clave);
+    if (existente != entradas.end()) {
+        total -= existente->second->tamano;
+        usos.erase(existente->second);
+    }
+    usos.push_front(Entrada{clave, tamano});
+    entradas[clave] = usos.begin();
+    total += tamano;
+}
+
+void CacheResultados::expulsar() {
+    error_code error;
+    while (total > tamanoMaximo && !usos.empty()) {
+        const Entrada& menosUsada = usos.back();
+        filesystem::remove(ruta(menosUsada.clave), error);
+        total -= menosUsada.tamano;
+        entradas.erase(menosUsada.clave);
+        usos.pop_back();
+    }
+}
+
+bool leerManifiesto(const char* nombreArchivo, vector<Trabajo>& trabajos) {
+    ifstream archivo(nombreArchivo);
+
+    if (!archivo) {
+        cerr << "No se pudo abrir el manifiesto: " << nombreArchivo << endl;
+        return false;
+    }
+
+    string linea;
+    int numLinea = 0;
+    while (getline(archivo, linea)) {
+        ++numLinea;
+        // Se ignoran las líneas vacías y los comentarios con #
+        size_t comentario = linea.find('#');
+        if (comentario != string::npos) linea.erase(comentario);
+
+        istringstream campos(linea);
+        Trabajo trabajo;
+        if (!(campos >> trabajo.entrada)) continue;
+
+        string sobrante;
+        if (!(campos >> trabajo.salida >> trabajo.metodo) || (campos >> sobrante) || !esMetodoValido(trabajo.metodo)) {
+            cerr << "Línea " << numLinea << " inválida en el manifiesto, se esperaba: <entrada.bmp> <salida.bmp> <umbral|otsu|media>" << endl;
+            return false;
+        }
+        trabajos.push_back(trabajo);
+    }
+    return true;
+}
+
+bool procesarTrabajo(const Trabajo& trabajo, Imagen& imagen, const Ejecucion& ejecucion, CacheResultados* cache,
+                     umbral_backend* usado, TiemposFases* tiempos) {
+    // Los contadores del hilo principal se cortan al terminar cada fase; los de los hilos del backend los lee cada hilo
+    unique_ptr<ContadoresHardware> contadores;
+    if (tiempos != nullptr && tiempos->conContadores) {
+        contadores.reset(new ContadoresHardware);
+        contadores->iniciar();
+    }
+    auto terminarFase = [&](LecturaContadores& lectura) {
+        lectura += contadores->detener();
+        contadores->iniciar();
+    };
+    // La memoria se corta igual, con lo acumulado por el proceso desde el corte anterior
+    LecturaMemoria memoriaAnterior = tiempos != nullptr ? leerMemoria() : LecturaMemoria();
+    auto terminarFaseMemoria = [&](LecturaMemoria& fase) {
+        LecturaMemoria actual = leerMemoria();
+        fase += diferenciaMemoria(memoriaAnterior, actual);
+        memoriaAnterior = actual;
+    };
+
+    // En la traza, un intervalo para toda la imagen y uno por fase; los que quedan abiertos se cierran al salir
+    IntervaloTraza trazaImagen("imagen", "trabajo");
+    IntervaloTraza trazaLectura("lectura", "fase");
+    uint64_t hash = 0;
+    if (!leerArchivoBMP(trabajo.entrada.c_str(), imagen, cache != nullptr ? &hash : nullptr, tiempos)) {
+        return false;
+    }
+    if (contadores) terminarFase(tiempos->contadoresLectura);
+    if (tiempos != nullptr) terminarFaseMemoria(tiempos->memoriaLectura);
+    trazaLectura.terminar();
+    uint64_t clave = 0;
+    if (cache != nullptr) {
+        clave = CacheResultados::clave(hash, imagen, trabajo.metodo);
+        if (cache->recuperar(clave, trabajo.salida)) {
+            return true;
+        }
+    }
+    // El umbralizado incluye calcular el umbral automático y elegir el backend
+    auto inicio = chrono::steady_clock::now();
+    IntervaloTraza trazaUmbralizado("umbralizado", "fase", "pixeles", static_cast<int64_t>(imagen.numPixeles()));
+    umbral_buffer buffer = bufferDeImagen(imagen);
+    TrabajoUmbral umbralizado{buffer, buffer, resolverUmbral(buffer, trabajo.metodo), ejecucion.kernel, ejecucion.filasPorBloque};
+    if (tiempos != nullptr) umbralizado.tiemposHilos = &tiempos->hilos;
+    if (contadores) umbralizado.contadoresHilos = &tiempos->contadoresHilos;
+    umbral_backend backend = ejecucion.backend;
+    int numHilos = ejecucion.numHilos;
+    if (backend == UMBRAL_BACKEND_AUTO) {
+        backend = resolverAuto(umbralizado, numHilos);
+    }
+    if (usado != nullptr) *usado = backend;
+    int estado = ejecutarBackend(backend, umbralizado, numHilos, ejecucion.pool);
+    if (estado != UMBRAL_OK) {
+        cerr << "Error al umbralizar " << trabajo.entrada << " con el backend " << nombreBackend(backend)
+             << ": " << umbral_mensaje(estado) << endl;
+        return false;
+    }
+    if (tiempos != nullptr) tiempos->umbralizado += microsegundosDesde(inicio);
+    if (contadores) terminarFase(tiempos->contadoresUmbralizado);
+    if (tiempos != nullptr) terminarFaseMemoria(tiempos->memoriaUmbralizado);
+    trazaUmbralizado.terminar();
+    IntervaloTraza trazaEscritura("escritura", "fase");
+    if (!guardarImagenEnBMP(trabajo.salida.c_str(), imagen, tiempos)) {
+        return false;
+    }
+    if (contadores) terminarFase(tiempos->contadoresEscritura);
+    if (tiempos != nullptr) terminarFaseMemoria(tiempos->memoriaEscritura);
+    if (cache != nullptr) {
+        cache->guardar(clave, trabajo.salida);
+    }
+    return true;
+}
+
+// procesarTrabajo midiendo lo que guarda MedicionTrabajo, si se pidió
+static bool procesarMidiendo(const Trabajo& trabajo, Imagen& imagen, const Ejecucion& ejecucion, CacheResultados* cache,
+                             MedicionTrabajo* medicion) {
+    if (medicion == nullptr) return procesarTrabajo(trabajo, imagen, ejecucion, cache);
+    auto inicio = chrono::steady_clock::now();
+    LecturaMemoria memoriaInicial = leerMemoria();
+    medicion->backend = ejecucion.backend;
+    medicion->correcto = procesarTrabajo(trabajo, imagen, ejecucion, cache, &medicion->backend, &medicion->tiempos);
+    medicion->totalUs = microsegundosDesde(inicio);
+    // Si falló, el buffer puede tener todavía las dimensiones de la imagen anterior
+    if (medicion->correcto) {
+        medicion->ancho = imagen.ancho;
+        medicion->alto = imagen.alto;
+    }
+    medicion->memoria = diferenciaMemoria(memoriaInicial, leerMemoria());
+    return medicion->correcto;
+}
+
+int procesarLote(const vector<Trabajo>& trabajos, const Ejecucion& ejecucion, CacheResultados* cache,
+                 vector<MedicionTrabajo>* mediciones, const function<void(const MedicionTrabajo&)>& alTerminar) {
+    // alTerminar necesita las mediciones aunque no se hayan pedido
+    vector<MedicionTrabajo> propias;
+    if (mediciones == nullptr && alTerminar) mediciones = &propias;
+    if (mediciones != nullptr) mediciones->assign(trabajos.size(), MedicionTrabajo());
+    auto medicionDe = [&](const Trabajo& trabajo) {
+        return mediciones != nullptr ? &(*mediciones)[&trabajo - trabajos.data()] : nullptr;
+    };
+    auto procesar = [&](const Trabajo& trabajo, Imagen& buffer, const Ejecucion& forma) {
+        MedicionTrabajo* medicion = medicionDe(trabajo);
+        bool correcto = procesarMidiendo(trabajo, buffer, forma, cache, medicion);
+        if (alTerminar) alTerminar(*medicion);
+        return correcto;
+    };
+    PoolHilos pool(ejecucion.numHilos);
+    Ejecucion pequena{UMBRAL_BACKEND_SECUENCIAL, 1, nullptr, ejecucion.kernel};
+    Ejecucion grande = ejecucion;
+    grande.pool = &pool;
+
+    vector<const Trabajo*> grandes;
+    mutex mtxFallos;
+    int fallos = 0;
+    int pendientesPequenas = 0;
+    condition_variable pequenasTerminadas;
+
+    // Las imágenes pequeñas se reparten entre los hilos, una por tarea
+    for (const Trabajo& trabajo : trabajos) {
+        if (tamanoSegunCabecera(trabajo.entrada) >= PIXELES_IMAGEN_GRANDE) {
+            grandes.push_back(&trabajo);
+            continue;
+        }
+        {
+            lock_guard<mutex> lock(mtxFallos);
+            ++pendientesPequenas;
+        }
+        pool.encolar([&, trabajoActual = &trabajo] {
+            // Cada hilo del pool reutiliza su propio buffer entre imágenes
+            thread_local Imagen buffer;
+            bool correcto = procesar(*trabajoActual, buffer, pequena);
+            lock_guard<mutex> lock(mtxFallos);
+            if (!correcto) ++fallos;
+            if (--pendientesPequenas == 0) pequenasTerminadas.notify_one();
+        });
+    }
+
+    // Las imágenes grandes se dividen por filas entre los mismos hilos
+    Imagen buffer;
+    for (const Trabajo* trabajo : grandes) {
+        if (!procesar(*trabajo, buffer, grande)) {
+            lock_guard<mutex> lock(mtxFallos);
+            ++fallos;
+        }
+    }
+
+    unique_lock<mutex> lock(mtxFallos);
+    pequenasTerminadas.wait(lock, [&] { return pendientesPequenas == 0; });
+    return fallos;
+}
@@ -0,0 +1,96 @@
+// Modo por lotes: lectura del manifiesto, cache de resultados en disco y reparto de las imágenes entre un pool de
+// hilos compartido. Lo usan el programa umbralizar y la función umbral_procesar_lote de la biblioteca.
+
+#ifndef LOTE_H
+#define LOTE_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <functional>
+#include <filesystem>
+
+#include "nucleo.h"
+#include "backends.h"
+
+// Cache de resultados en disco: un archivo BMP por clave, con expulsión de los menos usados recientemente
+class CacheResultados {
+public:
+    CacheResultados(const std::string& directorio, uintmax_t tamanoMaximo);
+
+    static uint64_t clave(uint64_t hashPixeles, const Imagen& imagen, const std::string& metodo);
+
+    // Copia el resultado guardado a la salida; devuelve false si no está en la cache
+    bool recuperar(uint64_t clave, const std::string& salida);
+    void guardar(uint64_t clave, const std::string& salida);
+
+private:
+    struct Entrada {
+        uint64_t clave;
+        uintmax_t tamano;
+    };
+
+    std::filesystem::path ruta(uint64_t clave) const;
+    // Las dos con mtx tomado
+    void usar(uint64_t clave, uintmax_t tamano);
+    void expulsar();
+
+    std::string directorio;
+    uintmax_t tamanoMaximo;
+    std::mutex mtx;
+    // El directorio se recorre solo al crear la cache; después las entradas se siguen en memoria, de la usada más
+    // recientemente a la que hace más que no se usa, con el total de bytes
+    std::list<Entrada> usos;
+    std::unordered_map<uint64_t, std::list<Entrada>::iterator> entradas;
+    uintmax_t total = 0;
+};
+
+struct Trabajo {
+    std::string entrada;
+    std::string salida;
+    std::string metodo;
+};
+
+// Cómo se umbraliza cada imagen: backend, número de hilos o procesos, el pool a usar con el backend de hilos (nulo
+// para el compartido), kernel y filas por bloque
+struct Ejecucion {
+    umbral_backend backend;
+    int numHilos;
+    PoolHilos* pool;
+    umbral_kernel kernel = UMBRAL_KERNEL_ESCALAR;
+    int filasPorBloque = 0;
+};
+
+// Líneas "<entrada.bmp> <salida.bmp> <umbral|otsu|media>"; se ignoran las vacías y lo que sigue a un #
+bool leerManifiesto(const char* nombreArchivo, std::vector<Trabajo>& trabajos);
+
+// Lee, umbraliza y guarda una imagen usando el buffer indicado. Con cache, si el resultado ya existe solo se copia.
+// En usado se devuelve el backend que se usó (el elegido, si se pidió UMBRAL_BACKEND_AUTO) y en tiempos se suma lo que
+// tardó cada fase.
+bool procesarTrabajo(const Trabajo& trabajo, Imagen& imagen, const Ejecucion& ejecucion, CacheResultados* cache,
+                     umbral_backend* usado = nullptr, TiemposFases* tiempos = nullptr);
+
+// Lo que se mide de cada imagen: el backend que se usó, las fases, el tiempo total y la memoria (las asignaciones y los
+// fallos de página de toda la imagen y el pico del proceso al terminarla)
+struct MedicionTrabajo {
+    bool correcto = false;
+    umbral_backend backend = UMBRAL_BACKEND_SECUENCIAL;
+    int ancho = 0;
+    int alto = 0;
+    TiemposFases tiempos;
+    double totalUs = 0;
+    LecturaMemoria memoria;
+};
+
+// Las imágenes grandes se umbralizan según grande, usando un pool de grande.numHilos hilos que también procesa las
+// pequeñas (una por tarea, con el backend secuencial). Devuelve cuántas imágenes fallaron. Con mediciones, deja en
+// (*mediciones)[i] lo medido de trabajos[i]. Con alTerminar, se llama con lo medido de cada imagen apenas termina, desde
+// el hilo que la procesó (puede haber varias llamadas a la vez).
+int procesarLote(const std::vector<Trabajo>& trabajos, const Ejecucion& grande, CacheResultados* cache,
+                 std::vector<MedicionTrabajo>* mediciones = nullptr,
+                 const std::function<void(const MedicionTrabajo&)>& alTerminar = nullptr);
+
+#endif
@@ -0,0 +1,148 @@
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sstream>
+
+#include "medicion.h"
+
+using namespace std;
+
+Estadisticas calcularEstadisticas(vector<double> muestras) {
+    Estadisticas estadisticas;
+    if (muestras.empty()) return estadisticas;
+    sort(muestras.begin(), muestras.end());
+    size_t n = muestras.size();
+    estadisticas.muestras = n;
+    estadisticas.minimo = muestras.front();
+    estadisticas.mediana = n % 2 ? muestras[n / 2] : (muestras[n / 2 - 1] + muestras[n / 2]) / 2;
+    // Percentil por rango más cercano: el menor valor que deja al menos el 95% de las muestras a su izquierda
+    estadisticas.p95 = muestras[static_cast<size_t>(ceil(0.95 * n)) - 1];
+    double suma = 0;
+    for (double muestra : muestras) suma += muestra;
+    estadisticas.media = suma / n;
+    double cuadrados = 0;
+    for (double muestra : muestras) cuadrados += (muestra - estadisticas.media) * (muestra - estadisticas.media);
+    estadisticas.desviacion = n > 1 ? sqrt(cuadrados / (n - 1)) : 0;
+    return estadisticas;
+}
+
+bool leerTamanos(const string& texto, vector<pair<int, int>>& tamanos) {
+    istringstream lista(texto);
+    string elemento;
+    while (getline(lista, elemento, ',')) {
+        int ancho, alto;
+        char x, sobrante;
+        istringstream campos(elemento);
+        if (!(campos >> ancho >> x >> alto) || x != 'x' || (campos >> sobrante) || ancho <= 0 || alto <= 0) {
+            return false;
+        }
+        tamanos.push_back({ancho, alto});
+    }
+    return !tamanos.empty();
+}
+
+string textoNumero(double valor) {
+    if (!isfinite(valor)) return "0";
+    char texto[32];
+    // Los enteros (bytes, contadores) completos; con %g los grandes perderían dígitos
+    if (valor == floor(valor) && fabs(valor) < 1e15) {
+        snprintf(texto, sizeof(texto), "%.0f", valor);
+    } else {
+        snprintf(texto, sizeof(texto), "%.6g", valor);
+    }
+    return texto;
+}
+
+string escaparJSON(const string& texto) {
+    string escapado;
+    for (char c : texto) {
+        if (c == '"' || c == '\\') {
+            escapado += '\\';
+            escapado += c;
+        } else if (static_cast<unsigned char>(c) < 0x20) {
+            char codigo[8];
+            snprintf(codigo, sizeof(codigo), "\\u%04x", c);
+            escapado += codigo;
+        } else {
+            escapado += c;
+        }
+    }
+    return escapado;
+}
+
+void TablaResultados::escribirCSV(ostream& salida, bool encabezado) const {
+    if (encabezado) {
+        for (size_t c = 0; c < columnas.size(); ++c) {
+            salida << (c ? "," : "") << columnas[c];
+        }
+        salida << "\n";
+    }
+    for (const auto& fila : filas) {
+        for (size_t c = 0; c < fila.size(); ++c) {
+            salida << (c ? "," : "") << fila[c].texto;
+        }
+        salida << "\n";
+    }
+}
+
+void TablaResultados::escribirObjeto(ostream& salida, const vector<Valor>& fila) const {
+    salida << "{";
+    for (size_t c = 0; c < fila.size() && c < columnas.size(); ++c) {
+        const Valor& valor = fila[c];
+        salida << (c ? ", " : "") << "\"" << columnas[c] << "\": ";
+        if (valor.numerico) {
+            salida << valor.texto;
+        } else {
+            salida << "\"" << escaparJSON(valor.texto) << "\"";
+        }
+    }
+    salida << "}";
+}
+
+void TablaResultados::escribirJSON(ostream& salida) const {
+    salida << "[\n";
+    for (size_t f = 0; f < filas.size(); ++f) {
+        salida << "  ";
+        escribirObjeto(salida, filas[f]);
+        salida << (f + 1 < filas.size() ? "," : "") << "\n";
+    }
+    salida << "]\n";
+}
+
+void TablaResultados::escribirJSONL(ostream& salida) const {
+    for (const auto& fila : filas) {
+        escribirObjeto(salida, fila);
+        salida << "\n";
+    }
+}
+
+void TablaResultados::escribir(ostream& salida, const string& formato) const {
+    if (formato == "json") {
+        escribirJSON(salida);
+    } else if (formato == "jsonl") {
+        escribirJSONL(salida);
+    } else {
+        escribirCSV(salida);
+    }
+}
+
+ostream& salidaInforme(const string& formato, const string& archivo) {
+    return !formato.empty() && archivo.empty() ? cerr : cout;
+}
+
+bool TablaResultados::escribirResultados(const string& formato, const string& archivo) const {
+    if (formato.empty()) return true;
+    if (archivo.empty()) {
+        escribir(cout, formato);
+        return true;
+    }
+    ofstream salida(archivo);
+    escribir(salida, formato);
+    if (!salida) {
+        cerr << "No se pudieron escribir los resultados en " << archivo << endl;
+        return false;
+    }
+    return true;
+}
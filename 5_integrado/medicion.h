@@ -0,0 +1,71 @@
+// Utilidades de medición compartidas por los comandos de benchmark: estadísticas de una serie de tiempos y salida en
+// CSV o JSON.
+
+#ifndef MEDICION_H
+#define MEDICION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include <ostream>
+#include <type_traits>
+
+// Estadísticas de una serie de tiempos, en las mismas unidades que las muestras
+struct Estadisticas {
+    size_t muestras = 0;
+    double minimo = 0;
+    double mediana = 0;
+    double p95 = 0;
+    double media = 0;
+    double desviacion = 0;
+};
+
+Estadisticas calcularEstadisticas(std::vector<double> muestras);
+
+// Tamaños de la forma "640x480,1920x1080"; devuelve false si alguno no tiene ese formato
+bool leerTamanos(const std::string& texto, std::vector<std::pair<int, int>>& tamanos);
+
+std::string textoNumero(double valor);
+std::string escaparJSON(const std::string& texto);
+
+// Donde va el resumen legible de un comando de benchmark: si los resultados van a la salida estándar (formato sin
+// archivo), a la salida de errores
+std::ostream& salidaInforme(const std::string& formato, const std::string& archivo);
+
+// Un valor de una fila de resultados: los numéricos van sin comillas en JSON
+struct Valor {
+    std::string texto;
+    bool numerico;
+
+    Valor(const std::string& texto) : texto(texto), numerico(false) {}
+    Valor(const char* texto) : texto(texto), numerico(false) {}
+    template <typename T, typename = typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    Valor(T valor) : texto(textoNumero(static_cast<double>(valor))), numerico(true) {}
+};
+
+// Tabla con columnas fijas que se escribe como CSV (con encabezado), como un arreglo JSON de objetos o como JSON lines
+class TablaResultados {
+public:
+    explicit TablaResultados(std::vector<std::string> columnas) : columnas(std::move(columnas)) {}
+
+    // Un valor por columna, en el mismo orden
+    void agregar(std::vector<Valor> fila) { filas.push_back(std::move(fila)); }
+
+    void escribirCSV(std::ostream& salida, bool encabezado = true) const;
+    void escribirJSON(std::ostream& salida) const;
+    // Un objeto JSON por línea, para poder agregar filas a un archivo que ya tiene otras
+    void escribirJSONL(std::ostream& salida) const;
+    // Según formato: "csv", "json" o "jsonl"
+    void escribir(std::ostream& salida, const std::string& formato) const;
+    // Lo que hacen los comandos de benchmark al terminar: nada sin formato, a la salida estándar sin archivo y si no al
+    // archivo. Devuelve false (y lo informa) si no se pudo escribir.
+    bool escribirResultados(const std::string& formato, const std::string& archivo) const;
+
+private:
+    void escribirObjeto(std::ostream& salida, const std::vector<Valor>& fila) const;
+
+    std::vector<std::string> columnas;
+    std::vector<std::vector<Valor>> filas;
+};
+
+#endif
@@ -0,0 +1,60 @@
+#include <algorithm>
+#include <sstream>
+#include <sys/resource.h>
+
+#include "memoria.h"
+
+using namespace std;
+
+atomic<uint64_t> asignacionesContadas(0);
+atomic<uint64_t> bytesAsignadosContados(0);
+bool contadorAsignacionesIncluido = false;
+
+LecturaMemoria& LecturaMemoria::operator+=(const LecturaMemoria& otra) {
+    picoKB = max(picoKB, otra.picoKB);
+    fallosMenores += otra.fallosMenores;
+    fallosMayores += otra.fallosMayores;
+    asignaciones += otra.asignaciones;
+    bytesAsignados += otra.bytesAsignados;
+    return *this;
+}
+
+LecturaMemoria leerMemoria() {
+    LecturaMemoria lectura;
+    rusage uso;
+    if (getrusage(RUSAGE_SELF, &uso) == 0) {
+        lectura.picoKB = uso.ru_maxrss;
+        lectura.fallosMenores = uso.ru_minflt;
+        lectura.fallosMayores = uso.ru_majflt;
+    }
+    // Los hijos del backend de procesos tocan páginas propias (y las compartidas por primera vez)
+    if (getrusage(RUSAGE_CHILDREN, &uso) == 0) {
+        lectura.fallosMenores += uso.ru_minflt;
+        lectura.fallosMayores += uso.ru_majflt;
+    }
+    lectura.asignaciones = asignacionesContadas.load(memory_order_relaxed);
+    lectura.bytesAsignados = bytesAsignadosContados.load(memory_order_relaxed);
+    return lectura;
+}
+
+LecturaMemoria diferenciaMemoria(const LecturaMemoria& antes, const LecturaMemoria& despues) {
+    LecturaMemoria diferencia;
+    diferencia.picoKB = despues.picoKB;
+    diferencia.fallosMenores = despues.fallosMenores - antes.fallosMenores;
+    diferencia.fallosMayores = despues.fallosMayores - antes.fallosMayores;
+    diferencia.asignaciones = despues.asignaciones - antes.asignaciones;
+    diferencia.bytesAsignados = despues.bytesAsignados - antes.bytesAsignados;
+    return diferencia;
+}
+
+string resumenMemoria(const LecturaMemoria& lectura) {
+    ostringstream salida;
+    if (contadorAsignacionesIncluido) {
+        salida << "asignaciones " << lectura.asignaciones << ", bytes asignados " << lectura.bytesAsignados;
+    } else {
+        salida << "asignaciones n/d, bytes asignados n/d";
+    }
+    salida << ", fallos de página " << lectura.fallosMenores << " (mayores " << lectura.fallosMayores << "), pico "
+           << lectura.picoKB << " KB";
+    return salida.str();
+}
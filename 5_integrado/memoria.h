@@ -0,0 +1,47 @@
+// Uso de memoria de una ejecución o de una fase: el pico de memoria residente y los fallos de página (de getrusage) y,
+// si el programa incluye el contador de asignaciones (asignaciones.cpp, que solo se compila en el ejecutable), cuántas
+// veces se pidió memoria dinámica y cuántos bytes. Sirve para ver cuánto cuesta la disposición de los píxeles en
+// memoria: con un vector por fila (como en las versiones 1 a 4) hay una asignación por fila; con un solo buffer, una
+// por imagen.
+//
+// Todo es del proceso entero: si otros hilos trabajan a la vez (por ejemplo en el modo por lotes), lo que hacen entra en
+// la fase que se esté midiendo. Los fallos de página de los procesos hijos cuentan desde que el padre los espera.
+
+#ifndef MEMORIA_H
+#define MEMORIA_H
+
+#include <cstddef>
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+struct LecturaMemoria {
+    size_t picoKB = 0;          // máximo de memoria residente del proceso hasta el final de lo medido
+    long fallosMenores = 0;     // fallos de página resueltos sin ir al disco (la primera vez que se toca cada página)
+    long fallosMayores = 0;
+    uint64_t asignaciones = 0;
+    uint64_t bytesAsignados = 0;
+
+    // Suma los fallos y las asignaciones; el pico es el mayor de los dos
+    LecturaMemoria& operator+=(const LecturaMemoria& otra);
+};
+
+// Los incrementa asignaciones.cpp en cada operator new
+extern std::atomic<uint64_t> asignacionesContadas;
+extern std::atomic<uint64_t> bytesAsignadosContados;
+extern bool contadorAsignacionesIncluido;
+
+inline void registrarAsignacion(size_t bytes) {
+    asignacionesContadas.fetch_add(1, std::memory_order_relaxed);
+    bytesAsignadosContados.fetch_add(bytes, std::memory_order_relaxed);
+}
+
+// Lo acumulado desde que empezó el proceso
+LecturaMemoria leerMemoria();
+// Lo que pasó entre dos lecturas
+LecturaMemoria diferenciaMemoria(const LecturaMemoria& antes, const LecturaMemoria& despues);
+
+// Una línea con las asignaciones ("n/d" si no se cuentan), los fallos de página y el pico
+std::string resumenMemoria(const LecturaMemoria& lectura);
+
+#endif
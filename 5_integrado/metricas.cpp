@@ -0,0 +1,50 @@
+#include <iostream>
+#include <fstream>
+#include <filesystem>
+
+#include "metricas.h"
+
+using namespace std;
+
+InformeMetricas::InformeMetricas()
+    : tabla({"modo", "entrada", "correcto", "backend", "hilos", "ancho", "alto", "lectura_us", "decodificacion_us",
+             "umbralizado_us", "codificacion_us", "escritura_us", "total_us", "mpx_s", "mb_s", "memoria_pico_kb",
+             "asignaciones", "bytes_asignados", "fallos_pagina_menores", "fallos_pagina_mayores"}) {}
+
+void InformeMetricas::agregar(const string& modo, const Trabajo& trabajo, const MedicionTrabajo& medicion) {
+    const TiemposFases& t = medicion.tiempos;
+    double pixeles = static_cast<double>(medicion.ancho) * medicion.alto;
+    // Igual que en bench: bytes leídos y escritos de los píxeles, por microsegundo = MB/s
+    double mpxPorSegundo = medicion.totalUs > 0 ? pixeles / medicion.totalUs : 0;
+    double mbPorSegundo = medicion.totalUs > 0 ? 2 * pixeles * sizeof(Pixel) / medicion.totalUs : 0;
+    const LecturaMemoria& m = medicion.memoria;
+    // Los hilos son las partes en que el backend dividió el trabajo; 0 si el resultado salió de la cache
+    tabla.agregar({modo, trabajo.entrada, medicion.correcto ? 1 : 0, nombreBackend(medicion.backend), t.hilos.size(),
+                   medicion.ancho, medicion.alto, t.lectura, t.decodificacion, t.umbralizado, t.codificacion,
+                   t.escritura, medicion.totalUs, mpxPorSegundo, mbPorSegundo, m.picoKB, m.asignaciones,
+                   m.bytesAsignados, m.fallosMenores, m.fallosMayores});
+}
+
+bool InformeMetricas::escribir(const string& ruta, const string& formato) const {
+    if (ruta == "-") {
+        if (formato == "csv") {
+            tabla.escribirCSV(cout);
+        } else {
+            tabla.escribirJSONL(cout);
+        }
+        return static_cast<bool>(cout);
+    }
+    error_code error;
+    bool vacio = !filesystem::exists(ruta, error) || filesystem::file_size(ruta, error) == 0;
+    ofstream archivo(ruta, ios::app);
+    if (formato == "csv") {
+        tabla.escribirCSV(archivo, vacio);
+    } else {
+        tabla.escribirJSONL(archivo);
+    }
+    if (!archivo) {
+        cerr << "No se pudieron escribir las métricas en " << ruta << endl;
+        return false;
+    }
+    return true;
+}
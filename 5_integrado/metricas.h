@@ -0,0 +1,29 @@
+// Informe estructurado de cada imagen procesada (--metricas), para que otros programas lo lean sin tener que interpretar
+// las líneas "tiempo ...": una fila por imagen con el backend, los hilos, las dimensiones, el tiempo de cada fase, el
+// rendimiento, el pico de memoria, las asignaciones y los fallos de página. Las filas se agregan al archivo, así que
+// varias ejecuciones se pueden acumular.
+
+#ifndef METRICAS_H
+#define METRICAS_H
+
+#include <string>
+
+#include "lote.h"
+#include "medicion.h"
+
+class InformeMetricas {
+public:
+    InformeMetricas();
+
+    // modo es "integrado" o "lote"
+    void agregar(const std::string& modo, const Trabajo& trabajo, const MedicionTrabajo& medicion);
+
+    // formato es "jsonl" o "csv"; ruta "-" es la salida estándar. En CSV el encabezado solo se escribe si el archivo
+    // está vacío.
+    bool escribir(const std::string& ruta, const std::string& formato) const;
+
+private:
+    TablaResultados tabla;
+};
+
+#endif
@@ -0,0 +1,124 @@
+#include <iostream>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+#include "micro.h"
+#include "nucleo.h"
+#include "medicion.h"
+
+using namespace std;
+
+// Cada muestra repite el kernel hasta durar por lo menos esto, para que la resolución del reloj no pese
+const double US_POR_MUESTRA = 1000;
+
+struct KernelMicro {
+    string nombre;
+    function<void()> ejecutar;
+};
+
+int ejecutarMicro(const OpcionesMicro& opciones) {
+    ostream& informe = salidaInforme(opciones.formato, opciones.salida);
+    TablaResultados tabla({"kernel", "ancho", "alto", "repeticiones", "ns_pixel", "ciclos_pixel", "mpx_s"});
+
+    informe << endl << "MEDICIÓN DE FORMA MICRO. .........." << endl;
+    int ancho = opciones.tamano.first;
+    int alto = opciones.tamano.second;
+    Imagen imagen, salida;
+    imagenSintetica(imagen, ancho, alto);
+    salida.ancho = ancho;
+    salida.alto = alto;
+    salida.pixeles.resize(imagen.numPixeles());
+    umbral_buffer bgr = bufferDeImagen(imagen);
+    umbral_buffer salidaBgr = bufferDeImagen(salida);
+
+    // Los mismos píxeles en los otros formatos de entrada
+    size_t pixeles = imagen.numPixeles();
+    vector<unsigned char> bgra(4 * pixeles), salidaBgra(4 * pixeles), gris(pixeles), salidaGris(pixeles);
+    vector<unsigned char> bits(bytesFilaBits(ancho) * alto);
+    for (int i = 0; i < alto; ++i) {
+        const Pixel* fila = imagen.fila(i);
+        for (int j = 0; j < ancho; ++j) {
+            unsigned char* p = &bgra[4 * (static_cast<size_t>(i) * ancho + j)];
+            p[0] = fila[j].blue;
+            p[1] = fila[j].green;
+            p[2] = fila[j].red;
+            p[3] = 255;
+        }
+        convertirFilaAGris(filaBuffer(bgr, i), &gris[static_cast<size_t>(i) * ancho], ancho, 3);
+    }
+    umbral_buffer vistaBgra{bgra.data(), ancho, alto, 4 * static_cast<ptrdiff_t>(ancho), UMBRAL_FORMATO_BGRA32};
+    umbral_buffer vistaSalidaBgra{salidaBgra.data(), ancho, alto, 4 * static_cast<ptrdiff_t>(ancho), UMBRAL_FORMATO_BGRA32};
+    umbral_buffer vistaGris{gris.data(), ancho, alto, ancho, UMBRAL_FORMATO_GRIS8};
+    umbral_buffer vistaSalidaGris{salidaGris.data(), ancho, alto, ancho, UMBRAL_FORMATO_GRIS8};
+
+    auto umbralizado = [alto](umbral_buffer entrada, umbral_buffer destino, umbral_kernel kernel) {
+        return [=] { umbralizarFilas(TrabajoUmbral{entrada, destino, 128, kernel}, 0, alto); };
+    };
+    size_t histograma[256];
+    vector<KernelMicro> kernels = {
+        {"escalar bgr24", umbralizado(bgr, salidaBgr, UMBRAL_KERNEL_ESCALAR)},
+        {"tabla bgr24", umbralizado(bgr, salidaBgr, UMBRAL_KERNEL_TABLA)},
+        {"escalar bgr24->gris8", umbralizado(bgr, vistaSalidaGris, UMBRAL_KERNEL_ESCALAR)},
+        {"tabla bgr24->gris8", umbralizado(bgr, vistaSalidaGris, UMBRAL_KERNEL_TABLA)},
+        {"escalar bgra32", umbralizado(vistaBgra, vistaSalidaBgra, UMBRAL_KERNEL_ESCALAR)},
+        {"tabla bgra32", umbralizado(vistaBgra, vistaSalidaBgra, UMBRAL_KERNEL_TABLA)},
+        {"conversion a gris", [&] {
+             for (int i = 0; i < alto; ++i) {
+                 convertirFilaAGris(filaBuffer(bgr, i), &salidaGris[static_cast<size_t>(i) * ancho], ancho, 3);
+             }
+         }},
+        {"histograma", [&] { calcularHistograma(bgr, histograma); }},
+        {"empaquetado 1 bit", [&] {
+             for (int i = 0; i < alto; ++i) {
+                 empaquetarFilaBits(&gris[static_cast<size_t>(i) * ancho], &bits[i * bytesFilaBits(ancho)], ancho, 128);
+             }
+         }},
+    };
+    // Cada versión de gris a gris que trae la compilación, no solo la que elige umbralizarFilas
+    for (const KernelGris& version : kernelsGris()) {
+        FuncionFila fila = version.fila;
+        kernels.push_back({string("gris8 ") + version.nombre, [&, fila] {
+             for (int i = 0; i < alto; ++i) {
+                 fila(filaBuffer(vistaGris, i), filaBuffer(vistaSalidaGris, i), ancho, 128, nullptr);
+             }
+         }});
+    }
+
+    for (const KernelMicro& kernel : kernels) {
+        // Una pasada para traer los buffers a la caché y otra para saber cuántas entran en una muestra
+        kernel.ejecutar();
+        auto inicio = chrono::steady_clock::now();
+        kernel.ejecutar();
+        long long vueltas = max(1LL, static_cast<long long>(US_POR_MUESTRA / max(microsegundosDesde(inicio), 0.001)));
+
+        ContadoresHardware contadores;
+        contadores.iniciar();
+        vector<double> nsPorPixel;
+        for (int r = 0; r < opciones.repeticiones; ++r) {
+            auto inicioMuestra = chrono::steady_clock::now();
+            for (long long v = 0; v < vueltas; ++v) kernel.ejecutar();
+            nsPorPixel.push_back(1000 * microsegundosDesde(inicioMuestra) / (static_cast<double>(vueltas) * pixeles));
+        }
+        LecturaContadores lectura = contadores.detener();
+
+        double ns = calcularEstadisticas(nsPorPixel).mediana;
+        // Los ciclos son de todas las muestras juntas: no hay un valor por muestra para sacar la mediana
+        double ciclos = lectura.disponible(CONTADOR_CICLOS)
+                            ? lectura.valores[CONTADOR_CICLOS] / (static_cast<double>(vueltas) * opciones.repeticiones * pixeles)
+                            : 0;
+        double mpxPorSegundo = ns > 0 ? 1000 / ns : 0;
+        tabla.agregar({kernel.nombre, ancho, alto, opciones.repeticiones, ns, ciclos, mpxPorSegundo});
+        informe << kernel.nombre << ": " << ns << " ns/píxel, ";
+        if (lectura.disponible(CONTADOR_CICLOS)) {
+            informe << ciclos << " ciclos/píxel, ";
+        } else {
+            informe << "ciclos n/d, ";
+        }
+        informe << mpxPorSegundo << " Mpx/s" << endl;
+    }
+    string error = errorContadores();
+    if (!error.empty()) informe << "contadores de hardware no disponibles (" << error << ")" << endl;
+
+    return tabla.escribirResultados(opciones.formato, opciones.salida) ? 0 : 1;
+}
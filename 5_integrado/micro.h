@@ -0,0 +1,20 @@
+// Comando micro: mide cada kernel por separado sobre buffers que entran en la caché, sin archivos, hilos ni backends,
+// y da el costo por píxel en nanosegundos y, si se pueden leer los contadores de hardware, en ciclos. Así se ve cuánto
+// cuesta el kernel en sí y cuánto agregan la memoria, la E/S y el reparto entre hilos que miden bench y escalado.
+
+#ifndef MICRO_H
+#define MICRO_H
+
+#include <string>
+#include <utility>
+
+struct OpcionesMicro {
+    std::pair<int, int> tamano; // del buffer; el valor por defecto (256x64) ocupa 48 KB en BGR24
+    int repeticiones;           // muestras de cada kernel; se informa la mediana
+    std::string formato;        // "csv" o "json"; vacío para solo el resumen legible
+    std::string salida;         // archivo para el formato elegido; vacío para la salida estándar
+};
+
+int ejecutarMicro(const OpcionesMicro& opciones);
+
+#endif
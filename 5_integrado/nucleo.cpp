@@ -0,0 +1,622 @@
+#include <iostream>
+#include <fstream>
+#include <map>
+#include <memory>
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#ifdef __SSE2__
+#include <emmintrin.h>
+#endif
+#if defined(__AVX2__) || defined(__AVX512BW__)
+#include <immintrin.h>
+#endif
+
+#include "nucleo.h"
+#include "traza.h"
+
+using namespace std;
+
+// Hash de 64 bits al estilo de xxHash64: cuatro acumuladores independientes para que las multiplicaciones se solapen
+const uint64_t PRIMO1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIMO2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIMO3 = 0x165667B19E3779F9ULL;
+
+inline uint64_t rotar(uint64_t x, int bits) { return (x << bits) | (x >> (64 - bits)); }
+
+inline uint64_t leer64(const unsigned char* p) {
+    uint64_t valor;
+    memcpy(&valor, p, sizeof(valor));
+    return valor;
+}
+
+inline uint64_t ronda(uint64_t acumulador, uint64_t valor) {
+    return rotar(acumulador + valor * PRIMO2, 31) * PRIMO1;
+}
+
+inline uint64_t mezclar(uint64_t h) {
+    h ^= h >> 33;
+    h *= PRIMO2;
+    h ^= h >> 29;
+    h *= PRIMO3;
+    h ^= h >> 32;
+    return h;
+}
+
+uint64_t hashBytes(const void* datos, size_t n, uint64_t semilla) {
+    const unsigned char* p = static_cast<const unsigned char*>(datos);
+    uint64_t h;
+    size_t total = n;
+    if (n >= 32) {
+        uint64_t a = semilla + PRIMO1 + PRIMO2, b = semilla + PRIMO2, c = semilla, d = semilla - PRIMO1;
+        for (; n >= 32; p += 32, n -= 32) {
+            a = ronda(a, leer64(p));
+            b = ronda(b, leer64(p + 8));
+            c = ronda(c, leer64(p + 16));
+            d = ronda(d, leer64(p + 24));
+        }
+        h = rotar(a, 1) + rotar(b, 7) + rotar(c, 12) + rotar(d, 18);
+    } else {
+        h = semilla + PRIMO3;
+    }
+    h += total;
+    for (; n >= 8; p += 8, n -= 8) {
+        h = rotar(h ^ ronda(0, leer64(p)), 27) * PRIMO1 + PRIMO3;
+    }
+    for (; n > 0; ++p, --n) {
+        h = rotar(h ^ (*p * PRIMO3), 11) * PRIMO1;
+    }
+    return mezclar(h);
+}
+
+double microsegundosDesde(chrono::steady_clock::time_point inicio) {
+    return chrono::duration<double, micro>(chrono::steady_clock::now() - inicio).count();
+}
+
+bool leerArchivoBMP(const char* nombreArchivo, Imagen& imagen, uint64_t* hash, TiemposFases* tiempos) {
+    auto inicio = chrono::steady_clock::now();
+    // Abrir el archivo y las llamadas a read cuentan como lectura; lo demás es decodificación
+    ifstream archivo(nombreArchivo, ios::binary);
+    double lectura = tiempos != nullptr ? microsegundosDesde(inicio) : 0;
+    auto leer = [&](char* destino, size_t n) -> bool {
+        IntervaloTraza intervalo("read", "io", "bytes", n);
+        if (tiempos == nullptr) return static_cast<bool>(archivo.read(destino, n));
+        auto inicioLectura = chrono::steady_clock::now();
+        bool correcto = static_cast<bool>(archivo.read(destino, n));
+        lectura += microsegundosDesde(inicioLectura);
+        return correcto;
+    };
+
+    if (!archivo) {
+        cerr << "No se pudo abrir el archivo BMP: " << nombreArchivo << endl;
+        return false;
+    }
+
+    BMPHeader header;
+    if (!leer(reinterpret_cast<char*>(&header), sizeof(BMPHeader)) ||
+        header.signature[0] != 'B' || header.signature[1] != 'M') {
+        cerr << "El archivo no es un BMP válido: " << nombreArchivo << endl;
+        return false;
+    }
+
+    if (header.bitsPerPixel != 24 || header.compression != 0) {
+        cerr << "El archivo BMP debe tener 24 bits por píxel sin compresión: " << nombreArchivo << endl;
+        return false;
+    }
+
+    if (header.width <= 0 || header.height <= 0) {
+        cerr << "Dimensiones no soportadas en " << nombreArchivo << endl;
+        return false;
+    }
+
+    // Mover el puntero al inicio de los datos de píxeles
+    archivo.seekg(header.dataOffset, ios::beg);
+
+    imagen.ancho = header.width;
+    imagen.alto = header.height;
+    // resize conserva la capacidad, así que un buffer reutilizado no vuelve a reservar memoria
+    imagen.pixeles.resize(imagen.numPixeles());
+
+    // Cada fila se lee de una vez junto con su relleno de alineación
+    int relleno = header.width % 4;
+    for (int i = 0; i < imagen.alto; ++i) {
+        leer(reinterpret_cast<char*>(imagen.fila(i)), sizeof(Pixel) * imagen.ancho);
+        archivo.seekg(relleno, ios::cur);
+        if (hash != nullptr) {
+            *hash = hashBytes(imagen.fila(i), sizeof(Pixel) * imagen.ancho, *hash);
+        }
+    }
+
+    if (!archivo) {
+        cerr << "El archivo BMP está incompleto: " << nombreArchivo << endl;
+        return false;
+    }
+    if (tiempos != nullptr) {
+        tiempos->lectura += lectura;
+        tiempos->decodificacion += microsegundosDesde(inicio) - lectura;
+    }
+    return true;
+}
+
+BMPHeader encabezadoBMP(int ancho, int alto) {
+    uint64_t tamanoDatos = static_cast<uint64_t>(alto) * (3ULL * ancho + ancho % 4);
+    bool cabe = sizeof(BMPHeader) + tamanoDatos <= static_cast<uint64_t>(numeric_limits<int>::max());
+    BMPHeader header;
+    header.signature[0] = 'B';
+    header.signature[1] = 'M';
+    header.fileSize = cabe ? static_cast<int>(sizeof(BMPHeader) + tamanoDatos) : 0;
+    header.reserved = 0;
+    header.dataOffset = sizeof(BMPHeader);
+    header.headerSize = 40;
+    header.width = ancho;
+    header.height = alto;
+    header.planes = 1;
+    header.bitsPerPixel = 24;
+    header.compression = 0;
+    header.dataSize = cabe ? static_cast<int>(tamanoDatos) : 0;
+    header.horizontalResolution = 0;
+    header.verticalResolution = 0;
+    header.colors = 0;
+    header.importantColors = 0;
+    return header;
+}
+
+bool guardarImagenEnBMP(const char* nombreArchivo, const Imagen& imagen, TiemposFases* tiempos) {
+    auto inicio = chrono::steady_clock::now();
+    ofstream archivo(nombreArchivo, ios::binary);
+
+    if (!archivo) {
+        cerr << "No se pudo crear el archivo BMP: " << nombreArchivo << endl;
+        return false;
+    }
+
+    // Los píxeles se escriben directamente desde la imagen, así que la codificación es solo el encabezado
+    auto inicioCodificacion = chrono::steady_clock::now();
+    int relleno = imagen.ancho % 4;
+    BMPHeader header = encabezadoBMP(imagen.ancho, imagen.alto);
+    double codificacion = tiempos != nullptr ? microsegundosDesde(inicioCodificacion) : 0;
+
+    {
+        IntervaloTraza intervalo("write", "io", "bytes", sizeof(BMPHeader));
+        archivo.write(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    }
+
+    // Escribir cada fila de una vez, rellenando con bytes de 0 para la alineación de 4 bytes
+    const char rellenoCeros[4] = {0, 0, 0, 0};
+    for (int i = 0; i < imagen.alto; ++i) {
+        IntervaloTraza intervalo("write", "io", "bytes", sizeof(Pixel) * imagen.ancho + relleno);
+        archivo.write(reinterpret_cast<const char*>(imagen.fila(i)), sizeof(Pixel) * imagen.ancho);
+        archivo.write(rellenoCeros, relleno);
+    }
+
+    if (!archivo) {
+        cerr << "Error al escribir el archivo BMP: " << nombreArchivo << endl;
+        return false;
+    }
+    if (tiempos != nullptr) {
+        tiempos->codificacion += codificacion;
+        tiempos->escritura += microsegundosDesde(inicio) - codificacion;
+    }
+    return true;
+}
+
+size_t bytesFilaBits(int ancho) {
+    return (static_cast<size_t>(ancho) + 31) / 32 * 4;
+}
+
+// movemask deja el primer píxel en el bit menos significativo; en BMP va en el más significativo
+static unsigned char invertirBits(unsigned char b) {
+    b = (b & 0xF0) >> 4 | (b & 0x0F) << 4;
+    b = (b & 0xCC) >> 2 | (b & 0x33) << 2;
+    return (b & 0xAA) >> 1 | (b & 0x55) << 1;
+}
+
+void empaquetarFilaBits(const unsigned char* gris, unsigned char* bits, int ancho, unsigned char umbral) {
+    static const struct TablaInvertida {
+        unsigned char valores[256];
+        TablaInvertida() { for (int b = 0; b < 256; ++b) valores[b] = invertirBits(b); }
+    } invertida;
+
+    int j = 0;
+#ifdef __SSE2__
+    const __m128i limite = _mm_set1_epi8(static_cast<char>(umbral));
+    for (; j + 16 <= ancho; j += 16) {
+        __m128i valores = _mm_loadu_si128(reinterpret_cast<const __m128i*>(gris + j));
+        int mascara = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_max_epu8(valores, limite), valores));
+        bits[j / 8] = invertida.valores[mascara & 0xFF];
+        bits[j / 8 + 1] = invertida.valores[mascara >> 8];
+    }
+#endif
+    for (; j < ancho; j += 8) {
+        unsigned char byte = 0;
+        for (int k = 0; k < 8 && j + k < ancho; ++k) {
+            if (gris[j + k] >= umbral) byte |= 0x80 >> k;
+        }
+        bits[j / 8] = byte;
+    }
+    // Relleno hasta el múltiplo de 4 bytes
+    for (size_t k = (ancho + 7) / 8; k < bytesFilaBits(ancho); ++k) {
+        bits[k] = 0;
+    }
+}
+
+bool guardarMascaraEnBMP(const char* nombreArchivo, const unsigned char* bits, int ancho, int alto) {
+    ofstream archivo(nombreArchivo, ios::binary);
+
+    if (!archivo) {
+        cerr << "No se pudo crear el archivo BMP: " << nombreArchivo << endl;
+        return false;
+    }
+
+    // Paleta de dos colores (azul, verde, rojo, reservado): 0 negro y 1 blanco
+    const unsigned char paleta[8] = {0, 0, 0, 0, 255, 255, 255, 0};
+    uint64_t tamanoDatos = static_cast<uint64_t>(alto) * bytesFilaBits(ancho);
+    // Como en encabezadoBMP: los tamaños que no entran en la cabecera quedan en 0
+    bool cabe = sizeof(BMPHeader) + sizeof(paleta) + tamanoDatos <= static_cast<uint64_t>(numeric_limits<int>::max());
+
+    BMPHeader header;
+    header.signature[0] = 'B';
+    header.signature[1] = 'M';
+    header.fileSize = cabe ? static_cast<int>(sizeof(BMPHeader) + sizeof(paleta) + tamanoDatos) : 0;
+    header.reserved = 0;
+    header.dataOffset = sizeof(BMPHeader) + sizeof(paleta);
+    header.headerSize = 40;
+    header.width = ancho;
+    header.height = alto;
+    header.planes = 1;
+    header.bitsPerPixel = 1;
+    header.compression = 0;
+    header.dataSize = cabe ? static_cast<int>(tamanoDatos) : 0;
+    header.horizontalResolution = 0;
+    header.verticalResolution = 0;
+    header.colors = 2;
+    header.importantColors = 0;
+
+    archivo.write(reinterpret_cast<char*>(&header), sizeof(BMPHeader));
+    archivo.write(reinterpret_cast<const char*>(paleta), sizeof(paleta));
+    archivo.write(reinterpret_cast<const char*>(bits), tamanoDatos);
+
+    if (!archivo) {
+        cerr << "Error al escribir el archivo BMP: " << nombreArchivo << endl;
+        return false;
+    }
+    return true;
+}
+
+size_t tamanoSegunCabecera(const string& nombreArchivo) {
+    ifstream archivo(nombreArchivo, ios::binary);
+    BMPHeader header;
+    if (!archivo.read(reinterpret_cast<char*>(&header), sizeof(BMPHeader)) || header.width <= 0 || header.height <= 0) {
+        return 0;
+    }
+    return static_cast<size_t>(header.width) * header.height;
+}
+
+umbral_buffer bufferDeImagen(Imagen& imagen) {
+    umbral_buffer buffer;
+    buffer.datos = imagen.pixeles.data();
+    buffer.ancho = imagen.ancho;
+    buffer.alto = imagen.alto;
+    buffer.paso = static_cast<ptrdiff_t>(sizeof(Pixel)) * imagen.ancho;
+    buffer.formato = UMBRAL_FORMATO_BGR24;
+    return buffer;
+}
+
+int bytesPorPixel(umbral_formato formato) {
+    switch (formato) {
+        case UMBRAL_FORMATO_BGR24:
+        case UMBRAL_FORMATO_RGB24:
+            return 3;
+        case UMBRAL_FORMATO_BGRA32:
+            return 4;
+        case UMBRAL_FORMATO_GRIS8:
+            return 1;
+    }
+    return 0;
+}
+
+// El promedio no depende del orden de los canales, así que BGR y RGB usan el mismo código
+template <int BYTES>
+inline unsigned char promedio(const unsigned char* p) {
+    if (BYTES == 1) return p[0];
+    return (p[0] + p[1] + p[2]) / 3;
+}
+
+void convertirFilaAGris(const unsigned char* entrada, unsigned char* salida, int ancho, int bytesPorPixel) {
+    if (bytesPorPixel == 1) {
+        copy(entrada, entrada + ancho, salida);
+        return;
+    }
+    for (int j = 0; j < ancho; ++j, entrada += bytesPorPixel) {
+        salida[j] = promedio<3>(entrada);
+    }
+}
+
+void calcularHistograma(const umbral_buffer& buffer, size_t histograma[256]) {
+    fill(histograma, histograma + 256, 0);
+    int bytes = bytesPorPixel(buffer.formato);
+    for (int i = 0; i < buffer.alto; ++i) {
+        const unsigned char* fila = filaBuffer(buffer, i);
+        for (int j = 0; j < buffer.ancho; ++j, fila += bytes) {
+            ++histograma[bytes == 1 ? fila[0] : promedio<3>(fila)];
+        }
+    }
+}
+
+unsigned char umbralOtsu(const size_t histograma[256]) {
+    double total = 0, sumaTotal = 0;
+    for (int t = 0; t < 256; ++t) {
+        total += histograma[t];
+        sumaTotal += static_cast<double>(t) * histograma[t];
+    }
+
+    double pesoFondo = 0, sumaFondo = 0, mejorVarianza = -1;
+    int mejorUmbral = 0;
+    for (int t = 0; t < 256; ++t) {
+        pesoFondo += histograma[t];
+        if (pesoFondo == 0) continue;
+        double pesoFrente = total - pesoFondo;
+        if (pesoFrente == 0) break;
+        sumaFondo += static_cast<double>(t) * histograma[t];
+        double mediaFondo = sumaFondo / pesoFondo;
+        double mediaFrente = (sumaTotal - sumaFondo) / pesoFrente;
+        double varianza = pesoFondo * pesoFrente * (mediaFondo - mediaFrente) * (mediaFondo - mediaFrente);
+        if (varianza > mejorVarianza) {
+            mejorVarianza = varianza;
+            mejorUmbral = t;
+        }
+    }
+    // Los píxeles con promedio <= mejorUmbral quedan en negro, así que el umbral de corte es el siguiente valor
+    return static_cast<unsigned char>(min(mejorUmbral + 1, 255));
+}
+
+unsigned char umbralMedia(const size_t histograma[256]) {
+    double total = 0, suma = 0;
+    for (int t = 0; t < 256; ++t) {
+        total += histograma[t];
+        suma += static_cast<double>(t) * histograma[t];
+    }
+    return total == 0 ? 0 : static_cast<unsigned char>(suma / total + 0.5);
+}
+
+bool esMetodoValido(const string& metodo) {
+    if (metodo == "otsu" || metodo == "media") return true;
+    if (metodo.empty() || metodo.size() > 3) return false;
+    for (char c : metodo) {
+        if (c < '0' || c > '9') return false;
+    }
+    return stoi(metodo) <= 255;
+}
+
+unsigned char resolverUmbral(const umbral_buffer& buffer, const string& metodo) {
+    if (metodo != "otsu" && metodo != "media") {
+        return static_cast<unsigned char>(stoi(metodo));
+    }
+    size_t histograma[256];
+    calcularHistograma(buffer, histograma);
+    return umbralDeHistograma(histograma, metodo);
+}
+
+unsigned char umbralDeHistograma(const size_t histograma[256], const string& metodo) {
+    return metodo == "otsu" ? umbralOtsu(histograma) : umbralMedia(histograma);
+}
+
+// Umbraliza una fila. BYTES_SALIDA es 1 (gris) o igual a BYTES_ENTRADA; con 4 bytes el alfa se copia.
+// El kernel escalar hace lo mismo que umbralizar() en las carpetas 1 a 4: una división y una comparación por píxel.
+// El kernel de tabla precalcula el resultado para cada suma de canales (0..765) y lo consulta sin dividir ni saltar.
+template <int BYTES_ENTRADA, int BYTES_SALIDA, bool TABLA>
+void umbralizarFila(const unsigned char* entrada, unsigned char* salida, int ancho, unsigned char umbral,
+                    const unsigned char* tabla) {
+    for (int j = 0; j < ancho; ++j, entrada += BYTES_ENTRADA, salida += BYTES_SALIDA) {
+        unsigned char valor;
+        if (TABLA) {
+            valor = tabla[BYTES_ENTRADA == 1 ? entrada[0] : entrada[0] + entrada[1] + entrada[2]];
+        } else {
+            valor = promedio<BYTES_ENTRADA>(entrada) < umbral ? 0 : 255;
+        }
+        if (BYTES_SALIDA == 4) salida[3] = entrada[3];
+        salida[0] = valor;
+        if (BYTES_SALIDA >= 3) salida[1] = salida[2] = valor;
+    }
+}
+
+#ifdef __SSE2__
+// Gris a gris, 16 píxeles por instrucción: max(v, umbral) == v exactamente cuando v >= umbral, y la comparación de
+// igualdad ya deja 0xFF o 0x00 en cada byte. Es el caso de los planos Y de video, que no necesitan promedio.
+void umbralizarFilaGrisSSE2(const unsigned char* entrada, unsigned char* salida, int ancho, unsigned char umbral,
+                            const unsigned char*) {
+    const __m128i limite = _mm_set1_epi8(static_cast<char>(umbral));
+    int j = 0;
+    for (; j + 16 <= ancho; j += 16) {
+        __m128i valores = _mm_loadu_si128(reinterpret_cast<const __m128i*>(entrada + j));
+        __m128i mascara = _mm_cmpeq_epi8(_mm_max_epu8(valores, limite), valores);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(salida + j), mascara);
+    }
+    for (; j < ancho; ++j) {
+        salida[j] = entrada[j] < umbral ? 0 : 255;
+    }
+}
+#endif
+
+#ifdef __AVX2__
+// Lo mismo con 32 píxeles por instrucción; solo si se compila con -mavx2 (o -march=native en una máquina con AVX2)
+void umbralizarFilaGrisAVX2(const unsigned char* entrada, unsigned char* salida, int ancho, unsigned char umbral,
+                            const unsigned char*) {
+    const __m256i limite = _mm256_set1_epi8(static_cast<char>(umbral));
+    int j = 0;
+    for (; j + 32 <= ancho; j += 32) {
+        __m256i valores = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(entrada + j));
+        __m256i mascara = _mm256_cmpeq_epi8(_mm256_max_epu8(valores, limite), valores);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(salida + j), mascara);
+    }
+    for (; j < ancho; ++j) {
+        salida[j] = entrada[j] < umbral ? 0 : 255;
+    }
+}
+#endif
+
+#ifdef __AVX512BW__
+// 64 píxeles por instrucción: AVX-512 compara sin signo directamente y deja una máscara de bits que se expande a bytes.
+// El final de la fila usa la misma máscara recortada, sin bucle escalar.
+void umbralizarFilaGrisAVX512(const unsigned char* entrada, unsigned char* salida, int ancho, unsigned char umbral,
+                              const unsigned char*) {
+    const __m512i limite = _mm512_set1_epi8(static_cast<char>(umbral));
+    for (int j = 0; j < ancho; j += 64) {
+        __mmask64 validos = ancho - j >= 64 ? ~0ULL : (1ULL << (ancho - j)) - 1;
+        __m512i valores = _mm512_maskz_loadu_epi8(validos, entrada + j);
+        _mm512_mask_storeu_epi8(salida + j, validos, _mm512_movm_epi8(_mm512_cmpge_epu8_mask(valores, limite)));
+    }
+}
+#endif
+
+vector<KernelGris> kernelsGris() {
+    vector<KernelGris> kernels = {{"escalar", umbralizarFila<1, 1, false>}};
+#ifdef __SSE2__
+    kernels.push_back({"sse2", umbralizarFilaGrisSSE2});
+#endif
+#ifdef __AVX2__
+    kernels.push_back({"avx2", umbralizarFilaGrisAVX2});
+#endif
+#ifdef __AVX512BW__
+    kernels.push_back({"avx512", umbralizarFilaGrisAVX512});
+#endif
+    return kernels;
+}
+
+template <bool TABLA>
+FuncionFila elegirFuncionFila(int bytesEntrada, int bytesSalida) {
+    if (bytesEntrada == 3 && bytesSalida == 1) return umbralizarFila<3, 1, TABLA>;
+    if (bytesEntrada == 4 && bytesSalida == 4) return umbralizarFila<4, 4, TABLA>;
+    if (bytesEntrada == 4 && bytesSalida == 1) return umbralizarFila<4, 1, TABLA>;
+#if defined(__AVX512BW__)
+    if (bytesEntrada == 1) return umbralizarFilaGrisAVX512;
+#elif defined(__AVX2__)
+    if (bytesEntrada == 1) return umbralizarFilaGrisAVX2;
+#elif defined(__SSE2__)
+    if (bytesEntrada == 1) return umbralizarFilaGrisSSE2;
+#else
+    if (bytesEntrada == 1) return umbralizarFila<1, 1, TABLA>;
+#endif
+    return umbralizarFila<3, 3, TABLA>;
+}
+
+void umbralizarFilas(const TrabajoUmbral& trabajo, int inicio, int fin) {
+    int bytesEntrada = bytesPorPixel(trabajo.entrada.formato);
+    int bytesSalida = bytesPorPixel(trabajo.salida.formato);
+    bool conTabla = trabajo.kernel == UMBRAL_KERNEL_TABLA;
+    FuncionFila fila = conTabla ? elegirFuncionFila<true>(bytesEntrada, bytesSalida)
+                                : elegirFuncionFila<false>(bytesEntrada, bytesSalida);
+
+    // Indexada por la suma de los tres canales o, en gris, por el valor del píxel
+    unsigned char tabla[3 * 255 + 1];
+    if (conTabla) {
+        for (int suma = 0; suma <= 3 * 255; ++suma) {
+            int valor = bytesEntrada == 1 ? suma : suma / 3;
+            tabla[suma] = valor < trabajo.umbral ? 0 : 255;
+        }
+    }
+
+    for (int i = inicio; i < fin; ++i) {
+        fila(filaBuffer(trabajo.entrada, i), filaBuffer(trabajo.salida, i), trabajo.entrada.ancho, trabajo.umbral, tabla);
+    }
+}
+
+const char* nombreKernel(umbral_kernel kernel) {
+    return kernel == UMBRAL_KERNEL_TABLA ? "tabla" : "escalar";
+}
+
+bool kernelPorNombre(const string& nombre, umbral_kernel& kernel) {
+    if (nombre == "escalar") kernel = UMBRAL_KERNEL_ESCALAR;
+    else if (nombre == "tabla") kernel = UMBRAL_KERNEL_TABLA;
+    else return false;
+    return true;
+}
+
+void imagenSintetica(Imagen& imagen, int ancho, int alto, uint32_t semilla) {
+    imagen.ancho = ancho;
+    imagen.alto = alto;
+    imagen.pixeles.resize(imagen.numPixeles());
+    // Degradado diagonal con ruido de un generador congruencial, para que la comparación no sea predecible
+    uint32_t estado = semilla * 2654435761u + 1;
+    for (int i = 0; i < alto; ++i) {
+        Pixel* fila = imagen.fila(i);
+        for (int j = 0; j < ancho; ++j) {
+            estado = estado * 1664525u + 1013904223u;
+            int base = (255 * (i + j)) / max(1, ancho + alto - 2);
+            int ruido = static_cast<int>(estado >> 26) - 32;
+            fila[j].blue = static_cast<unsigned char>(min(255, max(0, base + ruido)));
+            fila[j].green = static_cast<unsigned char>(min(255, max(0, base - ruido)));
+            fila[j].red = static_cast<unsigned char>(min(255, max(0, base + ruido / 2)));
+        }
+    }
+}
+
+PoolHilos::PoolHilos(int numHilos) {
+    for (int i = 0; i < numHilos; ++i) {
+        hilos.emplace_back([this] { trabajar(); });
+    }
+}
+
+PoolHilos::~PoolHilos() {
+    {
+        lock_guard<mutex> lock(mtx);
+        terminar = true;
+    }
+    hayTrabajo.notify_all();
+    for (auto& hilo : hilos) {
+        hilo.join();
+    }
+}
+
+void PoolHilos::encolar(function<void()> tarea) {
+    {
+        lock_guard<mutex> lock(mtx);
+        tareas.push(move(tarea));
+    }
+    hayTrabajo.notify_one();
+}
+
+void PoolHilos::ejecutarEnParalelo(int n, const function<void(int)>& tarea) {
+    mutex mtxGrupo;
+    condition_variable terminado;
+    int pendientes = n;
+    for (int k = 0; k < n; ++k) {
+        encolar([&, k] {
+            tarea(k);
+            lock_guard<mutex> lock(mtxGrupo);
+            if (--pendientes == 0) terminado.notify_one();
+        });
+    }
+    unique_lock<mutex> lock(mtxGrupo);
+    terminado.wait(lock, [&] { return pendientes == 0; });
+}
+
+void PoolHilos::trabajar() {
+    while (true) {
+        function<void()> tarea;
+        {
+            unique_lock<mutex> lock(mtx);
+            hayTrabajo.wait(lock, [this] { return terminar || !tareas.empty(); });
+            if (terminar && tareas.empty()) return;
+            tarea = move(tareas.front());
+            tareas.pop();
+        }
+        tarea();
+    }
+}
+
+PoolHilos& poolCompartido(int numHilos) {
+    static mutex mtxPools;
+    static map<int, unique_ptr<PoolHilos>> pools;
+    lock_guard<mutex> lock(mtxPools);
+    unique_ptr<PoolHilos>& pool = pools[numHilos];
+    if (!pool) {
+        pool.reset(new PoolHilos(numHilos));
+    }
+    return *pool;
+}
+
+int nucleosDisponibles() {
+    int nucleos = thread::hardware_concurrency();
+    return nucleos > 0 ? nucleos : 1;
+}
@@ -0,0 +1,193 @@
+// Partes compartidas por el programa umbralizar y la biblioteca libumbral: lectura y escritura de BMP, kernels de
+// umbralización, métodos automáticos y pool de hilos.
+
+#ifndef NUCLEO_H
+#define NUCLEO_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+#include <queue>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+
+#include "umbral.h"
+#include "contadores.h"
+#include "memoria.h"
+
+struct Pixel {
+    unsigned char blue;
+    unsigned char green;
+    unsigned char red;
+};
+
+#pragma pack(push, 1)
+struct BMPHeader {
+    char signature[2];
+    int fileSize;
+    int reserved;
+    int dataOffset;
+    int headerSize;
+    int width;
+    int height;
+    short planes;
+    short bitsPerPixel;
+    int compression;
+    int dataSize;
+    int horizontalResolution;
+    int verticalResolution;
+    int colors;
+    int importantColors;
+};
+#pragma pack(pop)
+
+// Imagen guardada por filas en un solo bloque, en el mismo orden en que vienen en el archivo BMP
+struct Imagen {
+    int ancho = 0;
+    int alto = 0;
+    std::vector<Pixel> pixeles;
+
+    Pixel* fila(int i) { return &pixeles[static_cast<size_t>(i) * ancho]; }
+    const Pixel* fila(int i) const { return &pixeles[static_cast<size_t>(i) * ancho]; }
+    size_t numPixeles() const { return static_cast<size_t>(ancho) * alto; }
+};
+
+// Imágenes con al menos esta cantidad de píxeles se dividen por filas entre los hilos
+const size_t PIXELES_IMAGEN_GRANDE = 1 << 20;
+
+uint64_t hashBytes(const void* datos, size_t n, uint64_t semilla);
+
+double microsegundosDesde(std::chrono::steady_clock::time_point inicio);
+
+// Tiempo de cada fase de una imagen, en microsegundos. La lectura y la escritura son solo las llamadas al archivo; la
+// decodificación y la codificación son el resto de leerArchivoBMP y guardarImagenEnBMP (encabezado, relleno, hash).
+struct TiemposFases {
+    double lectura = 0;
+    double decodificacion = 0;
+    double umbralizado = 0;
+    double codificacion = 0;
+    double escritura = 0;
+    // Lo que tardó cada hilo o proceso del backend en umbralizar su parte
+    std::vector<double> hilos;
+
+    // Con conContadores también se leen los contadores de hardware del hilo principal (la lectura y la decodificación se
+    // intercalan fila por fila, así que van juntas, igual que la codificación y la escritura) y los de cada hilo o
+    // proceso del backend
+    bool conContadores = false;
+    LecturaContadores contadoresLectura;
+    LecturaContadores contadoresUmbralizado;
+    LecturaContadores contadoresEscritura;
+    std::vector<LecturaContadores> contadoresHilos;
+
+    // Asignaciones, fallos de página y pico de memoria de las mismas tres partes (ver memoria.h)
+    LecturaMemoria memoriaLectura;
+    LecturaMemoria memoriaUmbralizado;
+    LecturaMemoria memoriaEscritura;
+};
+
+// Si se pasa hash, se calcula sobre cada fila justo después de leerla, mientras sigue en caché. Con tiempos se suman la
+// lectura y la decodificación.
+bool leerArchivoBMP(const char* nombreArchivo, Imagen& imagen, uint64_t* hash = nullptr, TiemposFases* tiempos = nullptr);
+bool guardarImagenEnBMP(const char* nombreArchivo, const Imagen& imagen, TiemposFases* tiempos = nullptr);
+// Encabezado de un BMP de 24 bits. Los campos de tamaño son de 32 bits: si la imagen no entra se dejan en 0, que para
+// un BMP sin compresión está permitido en dataSize; leerArchivoBMP no usa ninguno de los dos.
+BMPHeader encabezadoBMP(int ancho, int alto);
+
+// Máscaras de 1 bit por píxel, como en un BMP monocromo: el bit más significativo de cada byte es el píxel de más a la
+// izquierda, 1 es blanco y cada fila ocupa bytesFilaBits(ancho) bytes (múltiplo de 4)
+size_t bytesFilaBits(int ancho);
+void empaquetarFilaBits(const unsigned char* gris, unsigned char* bits, int ancho, unsigned char umbral);
+bool guardarMascaraEnBMP(const char* nombreArchivo, const unsigned char* bits, int ancho, int alto);
+
+// Devuelve la cantidad de píxeles según la cabecera, sin leer la imagen completa
+size_t tamanoSegunCabecera(const std::string& nombreArchivo);
+
+// Vista BGR24 sobre los píxeles de una imagen, para pasarla a los backends
+umbral_buffer bufferDeImagen(Imagen& imagen);
+
+int bytesPorPixel(umbral_formato formato);
+
+inline unsigned char* filaBuffer(const umbral_buffer& buffer, int i) {
+    return static_cast<unsigned char*>(buffer.datos) + i * buffer.paso;
+}
+
+// Promedio de canales de cada píxel, el mismo valor que comparan los kernels con el umbral
+void convertirFilaAGris(const unsigned char* entrada, unsigned char* salida, int ancho, int bytesPorPixel);
+
+// Métodos automáticos a partir del histograma del promedio de cada píxel
+void calcularHistograma(const umbral_buffer& buffer, size_t histograma[256]);
+unsigned char umbralOtsu(const size_t histograma[256]);
+unsigned char umbralMedia(const size_t histograma[256]);
+
+// Interpreta el umbral pedido: un número entre 0 y 255 o el nombre de un método automático ("otsu" o "media")
+bool esMetodoValido(const std::string& metodo);
+unsigned char resolverUmbral(const umbral_buffer& buffer, const std::string& metodo);
+
+// Umbral de un método automático a partir de un histograma ya calculado
+unsigned char umbralDeHistograma(const size_t histograma[256], const std::string& metodo);
+
+// Una umbralización pendiente: de entrada a salida (que pueden ser el mismo buffer)
+struct TrabajoUmbral {
+    umbral_buffer entrada;
+    umbral_buffer salida;
+    unsigned char umbral;
+    umbral_kernel kernel = UMBRAL_KERNEL_ESCALAR;
+    // Filas que toma cada hilo por vez; 0 reparte alto / hilos filas a cada uno, como en 2_hilos
+    int filasPorBloque = 0;
+    // Si no es nulo, el backend deja el tiempo que pasó umbralizando cada hilo o proceso, en microsegundos
+    std::vector<double>* tiemposHilos = nullptr;
+    // Si no es nulo, también los contadores de hardware de cada hilo o proceso
+    std::vector<LecturaContadores>* contadoresHilos = nullptr;
+};
+
+void umbralizarFilas(const TrabajoUmbral& trabajo, int inicio, int fin);
+
+// Las versiones del umbralizado de gris a gris que trae esta compilación, de la más angosta a la más ancha;
+// umbralizarFilas usa la última. El último argumento (la tabla) no se usa.
+typedef void (*FuncionFila)(const unsigned char* entrada, unsigned char* salida, int ancho, unsigned char umbral,
+                            const unsigned char* tabla);
+struct KernelGris {
+    const char* nombre;
+    FuncionFila fila;
+};
+std::vector<KernelGris> kernelsGris();
+
+const char* nombreKernel(umbral_kernel kernel);
+bool kernelPorNombre(const std::string& nombre, umbral_kernel& kernel);
+
+// Imagen de prueba: degradado con ruido, reproducible a partir de la semilla
+void imagenSintetica(Imagen& imagen, int ancho, int alto, uint32_t semilla = 1);
+
+// Pool de hilos que se reutiliza entre imágenes en lugar de crear hilos nuevos cada vez
+class PoolHilos {
+public:
+    explicit PoolHilos(int numHilos);
+    ~PoolHilos();
+
+    int tamano() const { return hilos.size(); }
+
+    void encolar(std::function<void()> tarea);
+
+    // Ejecuta tarea(0..n-1) en el pool y espera solo a esas tareas (no a las demás que haya en la cola)
+    void ejecutarEnParalelo(int n, const std::function<void(int)>& tarea);
+
+private:
+    void trabajar();
+
+    std::vector<std::thread> hilos;
+    std::queue<std::function<void()>> tareas;
+    std::mutex mtx;
+    std::condition_variable hayTrabajo;
+    bool terminar = false;
+};
+
+// Pool del proceso para un número de hilos dado; se crea la primera vez que se pide y vive hasta el final
+PoolHilos& poolCompartido(int numHilos);
+
+int nucleosDisponibles();
+
+#endif
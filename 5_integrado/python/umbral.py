@@ -0,0 +1,308 @@
+"""
+Enlace en Python para libumbral (ver ../umbral.h) usando ctypes.
+
+Las imágenes se pasan sin copiar: arreglos de NumPy (con o sin filas con relleno) u objetos que implementen el protocolo
+de buffer (bytearray, memoryview, array.array, ...). Las funciones de una biblioteca cargada con ctypes.CDLL se ejecutan
+sin el GIL, así que varios hilos de Python pueden umbralizar imágenes a la vez.
+
+Formas aceptadas: (alto, ancho) para gris, (alto, ancho, 3) para BGR o RGB y (alto, ancho, 4) para BGRA, siempre con
+elementos de un byte y los píxeles de cada fila contiguos. Un buffer plano también sirve si se indican ancho y alto.
+
+La biblioteca se busca en la variable de entorno UMBRAL_BIBLIOTECA, luego junto a este archivo (../libumbral.so) y por
+último en las rutas del sistema.
+"""
+
+import ctypes
+import os
+
+FORMATOS = {"bgr24": 0, "rgb24": 1, "bgra32": 2, "gris8": 3}
+BACKENDS = {"secuencial": 0, "hilos": 1, "procesos": 2, "openmp": 3, "auto": 4}
+KERNELS = {"escalar": 0, "tabla": 1}
+_BYTES_POR_PIXEL = {0: 3, 1: 3, 2: 4, 3: 1}
+
+
+class _Buffer(ctypes.Structure):
+    _fields_ = [
+        ("datos", ctypes.c_void_p),
+        ("ancho", ctypes.c_int),
+        ("alto", ctypes.c_int),
+        ("paso", ctypes.c_ssize_t),
+        ("formato", ctypes.c_int),
+    ]
+
+
+class _Opciones(ctypes.Structure):
+    _fields_ = [
+        ("backend", ctypes.c_int),
+        ("hilos", ctypes.c_int),
+        ("kernel", ctypes.c_int),
+        ("filas_por_bloque", ctypes.c_int),
+    ]
+
+
+class ErrorUmbral(RuntimeError):
+    def __init__(self, estado):
+        super().__init__(_biblioteca.umbral_mensaje(estado).decode("utf-8"))
+        self.estado = estado
+
+
+def _cargar():
+    candidatos = []
+    if os.environ.get("UMBRAL_BIBLIOTECA"):
+        candidatos.append(os.environ["UMBRAL_BIBLIOTECA"])
+    candidatos.append(os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "libumbral.so"))
+    candidatos.append("libumbral.so")
+    for ruta in candidatos:
+        try:
+            return ctypes.CDLL(ruta)
+        except OSError:
+            continue
+    raise OSError("No se encontró libumbral.so; compílela o indique su ruta en UMBRAL_BIBLIOTECA")
+
+
+_biblioteca = _cargar()
+_biblioteca.umbral_procesar.argtypes = [
+    ctypes.POINTER(_Buffer), ctypes.POINTER(_Buffer), ctypes.c_ubyte, ctypes.POINTER(_Opciones)]
+_biblioteca.umbral_histograma.argtypes = [ctypes.POINTER(_Buffer), ctypes.POINTER(ctypes.c_ulonglong * 256)]
+_biblioteca.umbral_calcular.argtypes = [ctypes.POINTER(_Buffer), ctypes.c_char_p, ctypes.POINTER(ctypes.c_ubyte)]
+_biblioteca.umbral_procesar_lote.argtypes = [
+    ctypes.c_char_p, ctypes.POINTER(_Opciones), ctypes.c_char_p, ctypes.c_ulonglong, ctypes.POINTER(ctypes.c_int)]
+_biblioteca.umbral_cargar_perfil.argtypes = [ctypes.c_char_p]
+_biblioteca.umbral_sesion_crear.argtypes = [ctypes.POINTER(_Buffer), ctypes.POINTER(ctypes.c_void_p)]
+_biblioteca.umbral_sesion_abrir.argtypes = [ctypes.c_char_p, ctypes.POINTER(ctypes.c_void_p)]
+_biblioteca.umbral_sesion_destruir.argtypes = [ctypes.c_void_p]
+_biblioteca.umbral_sesion_dimensiones.argtypes = [
+    ctypes.c_void_p, ctypes.POINTER(ctypes.c_int), ctypes.POINTER(ctypes.c_int)]
+_biblioteca.umbral_sesion_histograma.argtypes = [ctypes.c_void_p, ctypes.POINTER(ctypes.c_ulonglong * 256)]
+_biblioteca.umbral_sesion_calcular.argtypes = [ctypes.c_void_p, ctypes.c_char_p, ctypes.POINTER(ctypes.c_ubyte)]
+_biblioteca.umbral_sesion_region.argtypes = [
+    ctypes.c_void_p, ctypes.c_int, ctypes.c_int, ctypes.POINTER(_Buffer), ctypes.c_ubyte, ctypes.POINTER(_Opciones)]
+_biblioteca.umbral_sesion_vista_previa.argtypes = [ctypes.c_void_p, ctypes.c_int, ctypes.POINTER(_Buffer), ctypes.c_ubyte]
+_biblioteca.umbral_mensaje.argtypes = [ctypes.c_int]
+_biblioteca.umbral_mensaje.restype = ctypes.c_char_p
+
+
+def _comprobar(estado):
+    if estado != 0:
+        raise ErrorUmbral(estado)
+
+
+def _valor_umbral(umbral):
+    # ctypes recortaría en silencio un umbral fuera de rango a sus 8 bits bajos (256 pasaría a ser 0)
+    if not 0 <= umbral <= 255:
+        raise ValueError("El umbral debe estar entre 0 y 255: %r" % (umbral,))
+    return int(umbral)
+
+
+def _formato_por_canales(canales, formato):
+    if formato is not None:
+        if formato not in FORMATOS:
+            raise ValueError("Formato desconocido: %s" % formato)
+        codigo = FORMATOS[formato]
+        if _BYTES_POR_PIXEL[codigo] != canales:
+            raise ValueError("El formato %s no tiene %d canales" % (formato, canales))
+        return codigo
+    por_defecto = {1: "gris8", 3: "bgr24", 4: "bgra32"}
+    if canales not in por_defecto:
+        raise ValueError("Número de canales no soportado: %d" % canales)
+    return FORMATOS[por_defecto[canales]]
+
+
+def _describir(imagen, formato, ancho, alto, escritura):
+    """Devuelve (_Buffer, objeto que debe seguir vivo mientras se use el buffer) sin copiar los píxeles."""
+    interfaz = getattr(imagen, "__array_interface__", None)
+    if interfaz is not None:
+        direccion, solo_lectura = interfaz["data"]
+        if interfaz["typestr"][1:] not in ("u1", "i1"):
+            raise TypeError("Se esperaban elementos de un byte (uint8)")
+        if escritura and solo_lectura:
+            raise ValueError("El arreglo de salida es de solo lectura")
+        forma = interfaz["shape"]
+        pasos = interfaz.get("strides")
+        direccion += interfaz.get("offset", 0)
+    else:
+        vista = memoryview(imagen)
+        if vista.itemsize != 1:
+            raise TypeError("Se esperaban elementos de un byte")
+        if escritura and vista.readonly:
+            raise ValueError("El buffer de salida es de solo lectura")
+        if not vista.c_contiguous:
+            raise ValueError("Los buffers que no son de NumPy deben ser contiguos")
+        if vista.readonly:
+            if not isinstance(imagen, bytes):
+                raise TypeError("Solo se aceptan buffers de solo lectura de tipo bytes o arreglos de NumPy")
+            direccion = ctypes.cast(ctypes.c_char_p(imagen), ctypes.c_void_p).value
+        else:
+            direccion = ctypes.addressof(ctypes.c_char.from_buffer(vista))
+        forma = vista.shape
+        pasos = vista.strides
+
+    if len(forma) == 1:
+        if ancho is None or alto is None:
+            raise ValueError("Para un buffer plano hay que indicar ancho y alto")
+        if not (ancho > 0 and alto > 0):
+            raise ValueError("Dimensiones no válidas: %dx%d" % (ancho, alto))
+        canales, resto = divmod(forma[0], ancho * alto)
+        if resto != 0:
+            raise ValueError("El tamaño del buffer no corresponde a %dx%d" % (ancho, alto))
+        forma = (alto, ancho, canales)
+        pasos = None
+    elif len(forma) == 2:
+        forma = (forma[0], forma[1], 1)
+        pasos = None if pasos is None else (pasos[0], pasos[1], 1)
+    elif len(forma) != 3:
+        raise ValueError("Forma no soportada: %r" % (forma,))
+
+    alto, ancho, canales = forma
+    if pasos is None:
+        pasos = (ancho * canales, canales, 1)
+    if pasos[1] != canales or pasos[2] != 1:
+        raise ValueError("Los píxeles de cada fila deben ser contiguos")
+
+    buffer = _Buffer(direccion, ancho, alto, pasos[0], _formato_por_canales(canales, formato))
+    return buffer, imagen
+
+
+def _opciones(backend, hilos, kernel, filas_por_bloque):
+    if backend not in BACKENDS:
+        raise ValueError("Backend desconocido: %s" % backend)
+    if kernel not in KERNELS:
+        raise ValueError("Kernel desconocido: %s" % kernel)
+    return _Opciones(BACKENDS[backend], hilos, KERNELS[kernel], filas_por_bloque)
+
+
+def _nueva_salida(entrada, buffer, gris):
+    canales = 1 if gris else _BYTES_POR_PIXEL[buffer.formato]
+    if hasattr(entrada, "__array_interface__"):
+        import numpy
+        forma = (buffer.alto, buffer.ancho) if canales == 1 else (buffer.alto, buffer.ancho, canales)
+        return numpy.empty(forma, dtype=numpy.uint8)
+    return bytearray(buffer.alto * buffer.ancho * canales)
+
+
+def umbralizar(entrada, umbral, salida=None, gris=False, formato=None, backend="auto", hilos=0,
+               kernel="escalar", filas_por_bloque=0, ancho=None, alto=None):
+    """
+    Umbraliza entrada y devuelve la salida. umbral puede ser un número o un método ("otsu", "media").
+
+    Si no se da salida, se crea una del mismo tipo (o de un canal con gris=True). salida puede ser la misma entrada.
+    """
+    buffer_entrada, vivo_entrada = _describir(entrada, formato, ancho, alto, False)
+    if isinstance(umbral, str):
+        umbral = calcular_umbral(entrada, umbral, formato=formato, ancho=ancho, alto=alto)
+    umbral = _valor_umbral(umbral)
+    if salida is None:
+        salida = _nueva_salida(entrada, buffer_entrada, gris)
+    formato_salida = "gris8" if gris else formato
+    buffer_salida, vivo_salida = _describir(salida, formato_salida, buffer_entrada.ancho, buffer_entrada.alto, True)
+    opciones = _opciones(backend, hilos, kernel, filas_por_bloque)
+    _comprobar(_biblioteca.umbral_procesar(
+        ctypes.byref(buffer_entrada), ctypes.byref(buffer_salida), umbral, ctypes.byref(opciones)))
+    del vivo_entrada, vivo_salida
+    return salida
+
+
+def histograma(entrada, formato=None, ancho=None, alto=None):
+    """Lista de 256 cuentas del promedio de canales de cada píxel."""
+    buffer, vivo = _describir(entrada, formato, ancho, alto, False)
+    cuentas = (ctypes.c_ulonglong * 256)()
+    _comprobar(_biblioteca.umbral_histograma(ctypes.byref(buffer), ctypes.byref(cuentas)))
+    del vivo
+    return list(cuentas)
+
+
+def calcular_umbral(entrada, metodo="otsu", formato=None, ancho=None, alto=None):
+    """Umbral elegido por un método automático ("otsu" o "media")."""
+    buffer, vivo = _describir(entrada, formato, ancho, alto, False)
+    umbral = ctypes.c_ubyte()
+    _comprobar(_biblioteca.umbral_calcular(ctypes.byref(buffer), str(metodo).encode("utf-8"), ctypes.byref(umbral)))
+    del vivo
+    return umbral.value
+
+
+def procesar_lote(manifiesto, backend="auto", hilos=0, kernel="escalar", cache=None, cache_max_mb=1024):
+    """Procesa un manifiesto de imágenes BMP y devuelve cuántas fallaron."""
+    opciones = _opciones(backend, hilos, kernel, 0)
+    fallos = ctypes.c_int(0)
+    directorio = None if cache is None else os.fsencode(cache)
+    _comprobar(_biblioteca.umbral_procesar_lote(
+        os.fsencode(manifiesto), ctypes.byref(opciones), directorio, cache_max_mb * 1024 * 1024, ctypes.byref(fallos)))
+    return fallos.value
+
+
+def cargar_perfil(ruta):
+    """Carga un perfil generado por "umbralizar autotune"; se usa cuando backend="auto"."""
+    _comprobar(_biblioteca.umbral_cargar_perfil(os.fsencode(ruta)))
+
+
+class Sesion:
+    """
+    Imagen convertida a gris una sola vez, para volver a umbralizar regiones rápidamente al mover el umbral.
+
+    Se crea desde una imagen en memoria (mismos tipos que umbralizar) o, con Sesion.abrir, desde un archivo BMP.
+    """
+
+    def __init__(self, entrada=None, formato=None, ancho=None, alto=None, _puntero=None):
+        self._puntero = ctypes.c_void_p(_puntero)
+        if _puntero is None:
+            buffer, vivo = _describir(entrada, formato, ancho, alto, False)
+            _comprobar(_biblioteca.umbral_sesion_crear(ctypes.byref(buffer), ctypes.byref(self._puntero)))
+            del vivo
+        ancho, alto = ctypes.c_int(), ctypes.c_int()
+        _comprobar(_biblioteca.umbral_sesion_dimensiones(self._puntero, ctypes.byref(ancho), ctypes.byref(alto)))
+        self.ancho, self.alto = ancho.value, alto.value
+
+    @classmethod
+    def abrir(cls, ruta):
+        puntero = ctypes.c_void_p()
+        _comprobar(_biblioteca.umbral_sesion_abrir(os.fsencode(ruta), ctypes.byref(puntero)))
+        return cls(_puntero=puntero.value)
+
+    def cerrar(self):
+        if self._puntero:
+            _biblioteca.umbral_sesion_destruir(self._puntero)
+            self._puntero = ctypes.c_void_p()
+
+    def __del__(self):
+        self.cerrar()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *excepcion):
+        self.cerrar()
+
+    def histograma(self):
+        cuentas = (ctypes.c_ulonglong * 256)()
+        _comprobar(_biblioteca.umbral_sesion_histograma(self._puntero, ctypes.byref(cuentas)))
+        return list(cuentas)
+
+    def calcular_umbral(self, metodo="otsu"):
+        umbral = ctypes.c_ubyte()
+        _comprobar(_biblioteca.umbral_sesion_calcular(self._puntero, str(metodo).encode("utf-8"), ctypes.byref(umbral)))
+        return umbral.value
+
+    def _umbral(self, umbral):
+        return self.calcular_umbral(umbral) if isinstance(umbral, str) else _valor_umbral(umbral)
+
+    def region(self, x, y, ancho, alto, umbral, salida=None, backend="auto", hilos=0, kernel="escalar"):
+        """Máscara (un byte por píxel) del rectángulo con esquina (x, y); y en el orden de filas de la imagen original."""
+        if salida is None:
+            salida = bytearray(ancho * alto)
+        buffer, vivo = _describir(salida, "gris8", ancho, alto, True)
+        opciones = _opciones(backend, hilos, kernel, 0)
+        _comprobar(_biblioteca.umbral_sesion_region(
+            self._puntero, x, y, ctypes.byref(buffer), self._umbral(umbral), ctypes.byref(opciones)))
+        del vivo
+        return salida
+
+    def vista_previa(self, factor, umbral, salida=None):
+        """Máscara de la imagen reducida factor veces en cada dirección."""
+        ancho = (self.ancho + factor - 1) // factor
+        alto = (self.alto + factor - 1) // factor
+        if salida is None:
+            salida = bytearray(ancho * alto)
+        buffer, vivo = _describir(salida, "gris8", ancho, alto, True)
+        _comprobar(_biblioteca.umbral_sesion_vista_previa(self._puntero, factor, ctypes.byref(buffer), self._umbral(umbral)))
+        del vivo
+        return salida
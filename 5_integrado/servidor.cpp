@@ -0,0 +1,199 @@
+#include <iostream>
+#include <thread>
+#include <chrono>
+#include <atomic>
+#include <algorithm>
+#include <cstring>
+#include <csignal>
+#include <poll.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+
+#include "servidor.h"
+#include "compartida.h"
+#include "nucleo.h"
+#include "backends.h"
+#include "exportador.h"
+
+using namespace std;
+
+static volatile sig_atomic_t terminar = 0;
+static atomic<unsigned long long> trabajosAtendidos(0);
+static ExportadorMetricas* metricas = nullptr;
+
+static void pedirTerminar(int) {
+    terminar = 1;
+}
+
+// Un productor suele reutilizar los mismos segmentos para cada imagen, así que cada conexión guarda el último mapeo de
+// entrada y de salida y solo vuelve a llamar a mmap si llega un segmento distinto o cambió de tamaño
+struct Mapeo {
+    dev_t dispositivo = 0;
+    ino_t inodo = 0;
+    size_t tamano = 0;
+    void* datos = nullptr;
+
+    void liberar() {
+        if (datos != nullptr) munmap(datos, tamano);
+        datos = nullptr;
+    }
+
+    bool mapear(int descriptor, int proteccion) {
+        struct stat estado;
+        if (fstat(descriptor, &estado) != 0 || estado.st_size <= 0) return false;
+        size_t tamanoActual = estado.st_size;
+        if (datos != nullptr && estado.st_dev == dispositivo && estado.st_ino == inodo && tamanoActual == tamano) {
+            return true;
+        }
+        liberar();
+        void* nuevo = mmap(nullptr, tamanoActual, proteccion, MAP_SHARED, descriptor, 0);
+        if (nuevo == MAP_FAILED) return false;
+        datos = nuevo;
+        dispositivo = estado.st_dev;
+        inodo = estado.st_ino;
+        tamano = tamanoActual;
+        return true;
+    }
+};
+
+// Un segmento que el cliente pudiera achicar mientras está mapeado haría que el servidor recibiera SIGBUS al leerlo,
+// así que solo se aceptan memfd con F_SEAL_SHRINK (los que deja umbral_crear_segmento)
+static bool sellado(int descriptor) {
+    int sellos = fcntl(descriptor, F_GET_SEALS);
+    return sellos >= 0 && (sellos & F_SEAL_SHRINK) != 0;
+}
+
+static umbral_buffer bufferDeSegmento(const Mapeo& mapeo, const SegmentoMensaje& segmento) {
+    return umbral_buffer{static_cast<unsigned char*>(mapeo.datos) + segmento.desplazamiento, segmento.ancho,
+                         segmento.alto, static_cast<ptrdiff_t>(segmento.paso),
+                         static_cast<umbral_formato>(segmento.formato)};
+}
+
+// Cada conexión se atiende en su propio hilo, y un fork() copiaría los mutex que otros hilos tengan tomados en ese
+// momento: los backends con procesos no se aceptan en el servidor
+static bool usaFork(umbral_backend id) {
+    Backend backend;
+    return buscarBackend(id, backend) && backend.capacidades.usaFork;
+}
+
+// umbralizado queda en true si se llegó a umbralizar, y entonces el trabajo ya quedó registrado en las métricas
+static RespuestaTrabajo atender(MensajeTrabajo& mensaje, int descriptores[2], Mapeo& entrada, Mapeo& salida,
+                                bool& umbralizado) {
+    RespuestaTrabajo respuesta{UMBRAL_ERROR_ARGUMENTO, 0};
+    mensaje.metodo[sizeof(mensaje.metodo) - 1] = '\0';
+    if (!sellado(descriptores[0]) || !sellado(descriptores[1])) return respuesta;
+    if (!entrada.mapear(descriptores[0], PROT_READ) || !salida.mapear(descriptores[1], PROT_READ | PROT_WRITE)) {
+        respuesta.estado = UMBRAL_ERROR_SISTEMA;
+        return respuesta;
+    }
+    if (!segmentoCabe(mensaje.entrada, entrada.tamano) || !segmentoCabe(mensaje.salida, salida.tamano)) {
+        return respuesta;
+    }
+
+    umbral_buffer bufferEntrada = bufferDeSegmento(entrada, mensaje.entrada);
+    umbral_buffer bufferSalida = bufferDeSegmento(salida, mensaje.salida);
+    umbral_opciones opciones{static_cast<umbral_backend>(mensaje.backend), mensaje.hilos,
+                             static_cast<umbral_kernel>(mensaje.kernel), mensaje.filasPorBloque};
+    // Cada cantidad de hilos distinta crea un pool que no se libera, así que un cliente no puede pedir más que núcleos
+    opciones.hilos = min(opciones.hilos, nucleosDisponibles());
+    if (usaFork(opciones.backend)) {
+        respuesta.estado = UMBRAL_ERROR_BACKEND;
+        return respuesta;
+    }
+    // El modo automático no elige procesos por su cuenta, pero el perfil ajustado sí puede tenerlos
+    if (opciones.backend == UMBRAL_BACKEND_AUTO) {
+        TrabajoUmbral trabajo{bufferEntrada, bufferSalida, 0, opciones.kernel, opciones.filas_por_bloque};
+        int hilos = opciones.hilos > 0 ? opciones.hilos : nucleosDisponibles();
+        if (usaFork(resolverAuto(trabajo, hilos))) opciones.backend = elegirBackend(trabajo, hilos);
+    }
+    auto inicio = chrono::steady_clock::now();
+    respuesta.estado = umbral_calcular(&bufferEntrada, mensaje.metodo, &respuesta.umbral);
+    if (metricas != nullptr) metricas->observarFase("umbral", microsegundosDesde(inicio) / 1e6);
+    if (respuesta.estado != UMBRAL_OK) return respuesta;
+    inicio = chrono::steady_clock::now();
+    umbralizado = true;
+    respuesta.estado = umbral_procesar(&bufferEntrada, &bufferSalida, respuesta.umbral, &opciones);
+    if (metricas != nullptr) {
+        double segundos = microsegundosDesde(inicio) / 1e6;
+        metricas->observarFase("umbralizado", segundos);
+        // Sin los tiempos de cada hilo del backend, el de la conexión que espera a que terminen
+        metricas->trabajoTerminado(respuesta.estado == UMBRAL_OK,
+                                   static_cast<uint64_t>(bufferEntrada.ancho) * bufferEntrada.alto *
+                                       bytesPorPixel(bufferEntrada.formato),
+                                   static_cast<uint64_t>(bufferSalida.ancho) * bufferSalida.alto *
+                                       bytesPorPixel(bufferSalida.formato),
+                                   segundos);
+    }
+    return respuesta;
+}
+
+static void atenderConexion(int conexion) {
+    Mapeo entrada, salida;
+    MensajeTrabajo mensaje;
+    int descriptores[2];
+    int numDescriptores;
+    while (recibirConDescriptores(conexion, &mensaje, sizeof(mensaje), descriptores, 2, numDescriptores)) {
+        RespuestaTrabajo respuesta{UMBRAL_ERROR_ARGUMENTO, 0};
+        if (metricas != nullptr) metricas->trabajosRecibidos(1);
+        bool umbralizado = false;
+        if (numDescriptores == 2) {
+            respuesta = atender(mensaje, descriptores, entrada, salida, umbralizado);
+        }
+        // Los que no llegaron a umbralizarse también terminan, con error
+        if (metricas != nullptr && !umbralizado) metricas->trabajoTerminado(false, 0, 0, 0);
+        // Los mapeos siguen siendo válidos después de cerrar los descriptores
+        for (int i = 0; i < numDescriptores; ++i) close(descriptores[i]);
+        ++trabajosAtendidos;
+        if (!enviarConDescriptores(conexion, &respuesta, sizeof(respuesta), nullptr, 0)) break;
+    }
+    entrada.liberar();
+    salida.liberar();
+    close(conexion);
+}
+
+int ejecutarServidor(const string& rutaSocket, ExportadorMetricas* exportador) {
+    metricas = exportador;
+    sockaddr_un direccion{};
+    direccion.sun_family = AF_UNIX;
+    if (rutaSocket.size() >= sizeof(direccion.sun_path)) {
+        cerr << "Ruta de socket demasiado larga: " << rutaSocket << endl;
+        return 1;
+    }
+    strcpy(direccion.sun_path, rutaSocket.c_str());
+
+    int escucha = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (escucha < 0) {
+        cerr << "No se pudo crear el socket: " << strerror(errno) << endl;
+        return 1;
+    }
+    unlink(rutaSocket.c_str());
+    if (bind(escucha, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0 || listen(escucha, 16) != 0) {
+        cerr << "No se pudo escuchar en " << rutaSocket << ": " << strerror(errno) << endl;
+        close(escucha);
+        return 1;
+    }
+
+    struct sigaction accion{};
+    accion.sa_handler = pedirTerminar;
+    sigaction(SIGINT, &accion, nullptr);
+    sigaction(SIGTERM, &accion, nullptr);
+
+    std::cout << std::endl << "SERVIDOR EN " << rutaSocket << " .........." << std::endl;
+    while (!terminar) {
+        // Espera con límite para revisar periódicamente si llegó una señal
+        pollfd espera{escucha, POLLIN, 0};
+        if (poll(&espera, 1, 500) <= 0) continue;
+        int conexion = accept4(escucha, nullptr, nullptr, SOCK_CLOEXEC);
+        if (conexion < 0) continue;
+        thread(atenderConexion, conexion).detach();
+    }
+
+    close(escucha);
+    unlink(rutaSocket.c_str());
+    std::cout << "trabajos atendidos: " << trabajosAtendidos.load() << std::endl;
+    return 0;
+}
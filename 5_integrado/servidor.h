@@ -0,0 +1,15 @@
+// Modo servidor: escucha en un socket Unix y umbraliza imágenes que los productores dejan en memoria compartida (ver
+// compartida.h). Cada conexión se atiende en su propio hilo y puede enviar muchos trabajos seguidos.
+
+#ifndef SERVIDOR_H
+#define SERVIDOR_H
+
+#include <string>
+
+class ExportadorMetricas;
+
+// Atiende conexiones hasta recibir SIGINT o SIGTERM. Devuelve 0 si terminó normalmente. Con exportador, registra en él
+// cada trabajo (ver exportador.h).
+int ejecutarServidor(const std::string& rutaSocket, ExportadorMetricas* exportador = nullptr);
+
+#endif
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <cstdint>
+
+#include "sesion.h"
+#include "backends.h"
+
+using namespace std;
+
+SesionUmbral::SesionUmbral(const umbral_buffer& entrada)
+    : anchoImagen(entrada.ancho), altoImagen(entrada.alto), gris(static_cast<size_t>(entrada.ancho) * entrada.alto) {
+    int bytes = bytesPorPixel(entrada.formato);
+    // La conversión y el histograma se hacen en la misma pasada, por franjas en el pool si la imagen es grande
+    int numFranjas = entrada.ancho * static_cast<size_t>(entrada.alto) >= PIXELES_IMAGEN_GRANDE ?
+                     min(nucleosDisponibles(), entrada.alto) : 1;
+    vector<size_t> parciales(static_cast<size_t>(numFranjas) * 256, 0);
+    auto convertir = [&](int k) {
+        int inicio = static_cast<long long>(entrada.alto) * k / numFranjas;
+        int fin = static_cast<long long>(entrada.alto) * (k + 1) / numFranjas;
+        size_t* histograma = &parciales[static_cast<size_t>(k) * 256];
+        for (int i = inicio; i < fin; ++i) {
+            unsigned char* fila = &gris[static_cast<size_t>(i) * anchoImagen];
+            convertirFilaAGris(filaBuffer(entrada, i), fila, anchoImagen, bytes);
+            for (int j = 0; j < anchoImagen; ++j) {
+                ++histograma[fila[j]];
+            }
+        }
+    };
+    if (numFranjas == 1) {
+        convertir(0);
+    } else {
+        poolCompartido(numFranjas).ejecutarEnParalelo(numFranjas, convertir);
+    }
+    for (int t = 0; t < 256; ++t) {
+        cuentas[t] = 0;
+        for (int k = 0; k < numFranjas; ++k) cuentas[t] += parciales[static_cast<size_t>(k) * 256 + t];
+    }
+}
+
+umbral_buffer SesionUmbral::plano(unsigned char* datos, int ancho, int alto) const {
+    return umbral_buffer{datos, ancho, alto, static_cast<ptrdiff_t>(ancho), UMBRAL_FORMATO_GRIS8};
+}
+
+int SesionUmbral::umbralizarRegion(int x, int y, const umbral_buffer& salida, unsigned char umbral,
+                                   umbral_backend backend, int numHilos, umbral_kernel kernel) {
+    if (salida.formato != UMBRAL_FORMATO_GRIS8) return UMBRAL_ERROR_FORMATO;
+    if (x < 0 || y < 0 || salida.ancho > anchoImagen - x || salida.alto > altoImagen - y) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    umbral_buffer region = plano(&gris[static_cast<size_t>(y) * anchoImagen + x], salida.ancho, salida.alto);
+    region.paso = anchoImagen;
+    TrabajoUmbral trabajo{region, salida, umbral, kernel};
+    return ejecutarBackend(backend, trabajo, numHilos);
+}
+
+int SesionUmbral::vistaPrevia(int factor, const umbral_buffer& salida, unsigned char umbral) {
+    if (factor < 1) return UMBRAL_ERROR_ARGUMENTO;
+    int ancho = (anchoImagen + factor - 1) / factor;
+    int alto = (altoImagen + factor - 1) / factor;
+    if (salida.formato != UMBRAL_FORMATO_GRIS8) return UMBRAL_ERROR_FORMATO;
+    if (salida.ancho != ancho || salida.alto != alto) return UMBRAL_ERROR_ARGUMENTO;
+
+    lock_guard<mutex> lock(mtxPrevia);
+    if (factorPrevia != factor) {
+        // Promedio de cada bloque; los de los bordes pueden tener menos píxeles. Con factores muy grandes un bloque
+        // puede sumar más de lo que entra en 32 bits
+        previa.assign(static_cast<size_t>(ancho) * alto, 0);
+        vector<uint64_t> sumas(ancho);
+        for (int bi = 0; bi < alto; ++bi) {
+            fill(sumas.begin(), sumas.end(), 0);
+            int filas = min(factor, altoImagen - bi * factor);
+            for (int i = bi * factor; i < bi * factor + filas; ++i) {
+                const unsigned char* fila = &gris[static_cast<size_t>(i) * anchoImagen];
+                for (int j = 0; j < anchoImagen; ++j) sumas[j / factor] += fila[j];
+            }
+            for (int bj = 0; bj < ancho; ++bj) {
+                int columnas = min(factor, anchoImagen - bj * factor);
+                previa[static_cast<size_t>(bi) * ancho + bj] = sumas[bj] / (static_cast<uint64_t>(filas) * columnas);
+            }
+        }
+        factorPrevia = factor;
+    }
+    TrabajoUmbral trabajo{plano(previa.data(), ancho, alto), salida, umbral};
+    umbralizarFilas(trabajo, 0, alto);
+    return UMBRAL_OK;
+}
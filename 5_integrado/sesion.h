@@ -0,0 +1,43 @@
+// Sesión interactiva: la imagen se convierte a gris una sola vez y el plano gris y su histograma quedan en memoria,
+// así que mover el umbral solo vuelve a comparar los píxeles de la región visible. La vista previa trabaja sobre una
+// versión reducida del plano que se calcula la primera vez que se pide cada factor de reducción.
+
+#ifndef SESION_H
+#define SESION_H
+
+#include <vector>
+#include <mutex>
+
+#include "nucleo.h"
+
+class SesionUmbral {
+public:
+    explicit SesionUmbral(const umbral_buffer& entrada);
+
+    int ancho() const { return anchoImagen; }
+    int alto() const { return altoImagen; }
+    const size_t* histograma() const { return cuentas; }
+
+    // Umbraliza el rectángulo de esquina (x, y) y del tamaño de salida (GRIS8). y cuenta filas en el orden del buffer
+    // original. Devuelve un umbral_estado.
+    int umbralizarRegion(int x, int y, const umbral_buffer& salida, unsigned char umbral, umbral_backend backend,
+                         int numHilos, umbral_kernel kernel);
+
+    // Umbraliza el plano reducido factor veces en cada dirección (promedio de cada bloque de factor x factor) en salida,
+    // que tiene que ser GRIS8 de ceil(ancho / factor) x ceil(alto / factor).
+    int vistaPrevia(int factor, const umbral_buffer& salida, unsigned char umbral);
+
+private:
+    umbral_buffer plano(unsigned char* datos, int ancho, int alto) const;
+
+    int anchoImagen, altoImagen;
+    std::vector<unsigned char> gris;
+    size_t cuentas[256];
+
+    // La última vista previa; se protege porque varias regiones se pueden pedir desde hilos distintos
+    std::mutex mtxPrevia;
+    int factorPrevia = 0;
+    std::vector<unsigned char> previa;
+};
+
+#endif
@@ -0,0 +1,128 @@
+#include <iostream>
+#include <functional>
+#include <chrono>
+#include <cstring>
+#include <algorithm>
+
+#include "techo.h"
+#include "backends.h"
+#include "medicion.h"
+
+using namespace std;
+
+// Para que el compilador no descarte la suma de la prueba de lectura
+static volatile uint64_t sumidero;
+
+// Reparte [0, bytes) en numHilos partes alineadas a 64 bytes y ejecuta parte(inicio, fin) en cada una
+static void repartir(size_t bytes, int numHilos, const function<void(size_t, size_t)>& parte) {
+    auto limite = [&](int k) { return k == numHilos ? bytes : bytes / numHilos * k / 64 * 64; };
+    if (numHilos == 1) {
+        parte(0, bytes);
+        return;
+    }
+    poolCompartido(numHilos).ejecutarEnParalelo(numHilos, [&](int k) { parte(limite(k), limite(k + 1)); });
+}
+
+// Cuatro acumuladores independientes para que la suma no limite la lectura
+static void leerBytes(const unsigned char* datos, size_t inicio, size_t fin) {
+    uint64_t suma[4] = {0, 0, 0, 0};
+    size_t i = inicio;
+    for (; i + 32 <= fin; i += 32) {
+        for (int k = 0; k < 4; ++k) {
+            uint64_t palabra;
+            memcpy(&palabra, datos + i + 8 * k, sizeof(palabra));
+            suma[k] += palabra;
+        }
+    }
+    for (; i < fin; ++i) suma[0] += datos[i];
+    sumidero = sumidero + suma[0] + suma[1] + suma[2] + suma[3];
+}
+
+// Mediana de los tiempos de repeticiones ejecuciones, después de una de calentamiento; 0 si alguna falló
+static double medirMediana(int repeticiones, const function<bool()>& prueba) {
+    if (!prueba()) return 0;
+    vector<double> tiempos;
+    for (int r = 0; r < repeticiones; ++r) {
+        auto inicio = chrono::steady_clock::now();
+        if (!prueba()) return 0;
+        tiempos.push_back(microsegundosDesde(inicio));
+    }
+    return calcularEstadisticas(tiempos).mediana;
+}
+
+int ejecutarTecho(const OpcionesTecho& opciones) {
+    ostream& informe = salidaInforme(opciones.formato, opciones.salida);
+    TablaResultados tabla({"prueba", "kernel", "hilos", "bytes", "mediana_us", "gb_s", "fraccion_copia", "fraccion_maximo"});
+
+    informe << endl << "MEDICIÓN DE FORMA TECHO. .........." << endl;
+    Imagen entrada, salida;
+    imagenSintetica(entrada, opciones.tamano.first, opciones.tamano.second);
+    salida.ancho = entrada.ancho;
+    salida.alto = entrada.alto;
+    salida.pixeles.resize(entrada.numPixeles());
+    // Las pruebas de memoria usan los mismos buffers que los backends
+    const unsigned char* origen = reinterpret_cast<const unsigned char*>(entrada.pixeles.data());
+    unsigned char* destino = reinterpret_cast<unsigned char*>(salida.pixeles.data());
+    size_t bytes = entrada.numPixeles() * sizeof(Pixel);
+
+    // Con un hilo y con los pedidos: el backend secuencial se compara con el primero y los paralelos con el segundo
+    vector<int> hilos = {1};
+    if (opciones.numHilos > 1) hilos.push_back(opciones.numHilos);
+    double maximoCopia = 0;
+    vector<double> copiaPorHilos(hilos.size());
+    for (size_t h = 0; h < hilos.size(); ++h) {
+        int numHilos = hilos[h];
+        // Como en STREAM, la copia cuenta los bytes leídos y los escritos
+        struct PruebaMemoria {
+            const char* nombre;
+            double bytesMovidos;
+            function<void(size_t, size_t)> parte;
+        };
+        PruebaMemoria pruebas[] = {
+            {"lectura", static_cast<double>(bytes), [&](size_t i, size_t f) { leerBytes(origen, i, f); }},
+            {"escritura", static_cast<double>(bytes), [&](size_t i, size_t f) { memset(destino + i, 0x5A, f - i); }},
+            {"copia", 2.0 * bytes, [&](size_t i, size_t f) { memcpy(destino + i, origen + i, f - i); }},
+        };
+        for (const PruebaMemoria& prueba : pruebas) {
+            double mediana = medirMediana(opciones.repeticiones, [&] {
+                repartir(bytes, numHilos, prueba.parte);
+                return true;
+            });
+            double gbPorSegundo = prueba.bytesMovidos / mediana / 1000; // bytes por microsegundo / 1000 = GB/s
+            if (string(prueba.nombre) == "copia") {
+                copiaPorHilos[h] = gbPorSegundo;
+                maximoCopia = max(maximoCopia, gbPorSegundo);
+            }
+            tabla.agregar({prueba.nombre, "", numHilos, prueba.bytesMovidos, mediana, gbPorSegundo, "", ""});
+            informe << prueba.nombre << " hilos=" << numHilos << ": " << gbPorSegundo << " GB/s" << endl;
+        }
+    }
+
+    // Cada backend lee la entrada y escribe la salida una vez: los mismos bytes que la copia
+    int fallos = 0;
+    for (const Backend& backend : backendsRegistrados()) {
+        if (!backend.capacidades.disponible) continue;
+        bool paralelo = backend.capacidades.paralelo && hilos.size() > 1;
+        int numHilos = paralelo ? opciones.numHilos : 1;
+        TrabajoUmbral trabajo{bufferDeImagen(entrada), bufferDeImagen(salida), 128, opciones.kernel};
+        double mediana = medirMediana(opciones.repeticiones, [&] {
+            return ejecutarBackend(backend.id, trabajo, numHilos) == UMBRAL_OK;
+        });
+        if (mediana <= 0) {
+            cerr << "Falló el backend " << backend.nombre << endl;
+            ++fallos;
+            continue;
+        }
+        double gbPorSegundo = 2.0 * bytes / mediana / 1000;
+        double fraccionCopia = gbPorSegundo / copiaPorHilos[paralelo ? 1 : 0];
+        double fraccionMaximo = gbPorSegundo / maximoCopia;
+        tabla.agregar({backend.nombre, nombreKernel(opciones.kernel), numHilos, 2.0 * bytes, mediana, gbPorSegundo,
+                       fraccionCopia, fraccionMaximo});
+        informe << backend.nombre << " kernel=" << nombreKernel(opciones.kernel) << " hilos=" << numHilos << ": "
+                << gbPorSegundo << " GB/s, " << 100 * fraccionCopia << "% de la copia con los mismos hilos, "
+                << 100 * fraccionMaximo << "% de la más rápida" << endl;
+    }
+
+    if (!tabla.escribirResultados(opciones.formato, opciones.salida)) return 1;
+    return fallos == 0 ? 0 : 1;
+}
@@ -0,0 +1,25 @@
+// Comando techo: mide el ancho de banda de memoria que alcanza la máquina (lectura, escritura y copia, como STREAM) y
+// cuánto de ese techo usa cada backend. Umbralizar es una pasada que lee y escribe cada byte una vez, igual que una
+// copia, así que el tiempo de la copia sobre los mismos buffers es lo mejor que se puede esperar de un backend; los que
+// se acercan al 100% ya no mejoran con más hilos ni con un kernel más rápido.
+
+#ifndef TECHO_H
+#define TECHO_H
+
+#include <string>
+#include <utility>
+
+#include "umbral.h"
+
+struct OpcionesTecho {
+    int numHilos;
+    std::pair<int, int> tamano; // imagen BGR24; tiene que ser bastante más grande que la caché de último nivel
+    int repeticiones;
+    umbral_kernel kernel;
+    std::string formato; // "csv" o "json"; vacío para solo el resumen legible
+    std::string salida;  // archivo para el formato elegido; vacío para la salida estándar
+};
+
+int ejecutarTecho(const OpcionesTecho& opciones);
+
+#endif
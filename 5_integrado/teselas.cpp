@@ -0,0 +1,105 @@
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <mutex>
+
+#include "teselas.h"
+
+using namespace std;
+
+UmbralizadorIncremental::UmbralizadorIncremental(int ancho, int alto, int tamanoTesela, bool conHistograma)
+    : ancho(ancho), alto(alto), tamano(tamanoTesela),
+      columnas((ancho + tamanoTesela - 1) / tamanoTesela), filas((alto + tamanoTesela - 1) / tamanoTesela),
+      cambio(columnas * filas, 1), cambioAnterior(columnas * filas, 1), conHistograma(conHistograma),
+      histogramas(conHistograma ? static_cast<size_t>(columnas) * filas * 256 : 0) {}
+
+// Ejecuta tarea(0..n-1) en el pool o, sin pool, en el hilo actual
+static void repartir(int n, PoolHilos* pool, const function<void(int)>& tarea) {
+    if (pool == nullptr) {
+        for (int k = 0; k < n; ++k) tarea(k);
+    } else {
+        pool->ejecutarEnParalelo(n, tarea);
+    }
+}
+
+void UmbralizadorIncremental::comparar(const umbral_buffer& entrada, const unsigned char* anterior, PoolHilos* pool) {
+    swap(cambio, cambioAnterior);
+    int bytes = bytesPorPixel(entrada.formato);
+    mutex mtxTotal;
+    // Una tarea por franja de teselas. memcmp ya compara con instrucciones vectoriales y se detiene en la primera
+    // diferencia, así que una tesela que cambió suele costar solo una fila.
+    repartir(filas, pool, [&](int f) {
+        int primeraFila = f * tamano;
+        int ultimaFila = min(alto, primeraFila + tamano);
+        // Diferencia de la franja con el histograma del cuadro anterior; se suma al total una sola vez al final
+        long long diferencia[256] = {};
+        bool huboCambios = false;
+        for (int c = 0; c < columnas; ++c) {
+            size_t desplazamiento = static_cast<size_t>(c) * tamano * bytes;
+            int anchoTesela = min(tamano, ancho - c * tamano);
+            size_t bytesTesela = static_cast<size_t>(anchoTesela) * bytes;
+            bool distinta = anterior == nullptr;
+            for (int i = primeraFila; i < ultimaFila && !distinta; ++i) {
+                const unsigned char* actual = filaBuffer(entrada, i) + desplazamiento;
+                distinta = memcmp(actual, anterior + i * entrada.paso + desplazamiento, bytesTesela) != 0;
+            }
+            int indice = f * columnas + c;
+            cambio[indice] = distinta;
+            if (!distinta || !conHistograma) continue;
+
+            umbral_buffer tesela = entrada;
+            tesela.datos = filaBuffer(entrada, primeraFila) + desplazamiento;
+            tesela.ancho = anchoTesela;
+            tesela.alto = ultimaFila - primeraFila;
+            size_t nuevo[256];
+            calcularHistograma(tesela, nuevo);
+            uint32_t* guardado = &histogramas[static_cast<size_t>(indice) * 256];
+            for (int t = 0; t < 256; ++t) {
+                diferencia[t] += static_cast<long long>(nuevo[t]) - guardado[t];
+                guardado[t] = nuevo[t];
+            }
+            huboCambios = true;
+        }
+        if (huboCambios) {
+            lock_guard<mutex> lock(mtxTotal);
+            for (int t = 0; t < 256; ++t) total[t] += diferencia[t];
+        }
+    });
+}
+
+int UmbralizadorIncremental::umbralizar(const TrabajoUmbral& trabajo, int indiceSalida, PoolHilos* pool) {
+    bool todas = umbralSalida[indiceSalida] != trabajo.umbral;
+    umbralSalida[indiceSalida] = trabajo.umbral;
+    int bytesEntrada = bytesPorPixel(trabajo.entrada.formato);
+    int bytesSalida = bytesPorPixel(trabajo.salida.formato);
+    atomic<int> umbralizadas(0);
+
+    repartir(filas, pool, [&](int f) {
+        int primeraFila = f * tamano;
+        int altoFranja = min(alto, primeraFila + tamano) - primeraFila;
+        int c = 0;
+        while (c < columnas) {
+            auto pendiente = [&](int k) {
+                return todas || cambio[f * columnas + k] || cambioAnterior[f * columnas + k];
+            };
+            if (!pendiente(c)) {
+                ++c;
+                continue;
+            }
+            // Las teselas pendientes contiguas se umbralizan juntas, como un solo rectángulo
+            int fin = c + 1;
+            while (fin < columnas && pendiente(fin)) ++fin;
+            int x = c * tamano;
+            int anchoRectangulo = min(ancho, fin * tamano) - x;
+            TrabajoUmbral rectangulo = trabajo;
+            rectangulo.entrada.datos = filaBuffer(trabajo.entrada, primeraFila) + static_cast<size_t>(x) * bytesEntrada;
+            rectangulo.salida.datos = filaBuffer(trabajo.salida, primeraFila) + static_cast<size_t>(x) * bytesSalida;
+            rectangulo.entrada.ancho = rectangulo.salida.ancho = anchoRectangulo;
+            rectangulo.entrada.alto = rectangulo.salida.alto = altoFranja;
+            umbralizarFilas(rectangulo, 0, altoFranja);
+            umbralizadas += fin - c;
+            c = fin;
+        }
+    });
+    return umbralizadas;
+}
@@ -0,0 +1,44 @@
+// Umbralizado incremental para secuencias de cuadros en las que casi todo el fondo es estático: el cuadro se divide en
+// teselas cuadradas, cada una se compara con la del cuadro anterior y solo se vuelven a umbralizar las que cambiaron.
+// El resto de la salida se reutiliza del cuadro en que se calculó. Para los métodos automáticos también se mantiene el
+// histograma del cuadro, actualizando solo la parte de las teselas que cambiaron.
+
+#ifndef TESELAS_H
+#define TESELAS_H
+
+#include <cstdint>
+#include <vector>
+
+#include "nucleo.h"
+
+class UmbralizadorIncremental {
+public:
+    // Con conHistograma se guarda un histograma por tesela (256 contadores) para actualizar el del cuadro
+    UmbralizadorIncremental(int ancho, int alto, int tamanoTesela, bool conHistograma = false);
+
+    // Marca las teselas de entrada que difieren de anterior (con el mismo paso y formato); sin anterior, todas.
+    // Con histograma, recalcula el de las teselas marcadas y ajusta el del cuadro con la diferencia.
+    void comparar(const umbral_buffer& entrada, const unsigned char* anterior, PoolHilos* pool);
+
+    // Histograma del cuadro comparado por última vez, como el de calcularHistograma
+    const size_t* histograma() const { return total; }
+
+    // Umbraliza en trabajo.salida las teselas cuyo resultado no está ya en ese buffer. Se usan dos buffers de salida
+    // alternados (indiceSalida 0 o 1), así que una tesela se puede reutilizar si no cambió en este cuadro ni en el
+    // anterior y el buffer se calculó con el mismo umbral. Devuelve cuántas teselas se umbralizaron.
+    int umbralizar(const TrabajoUmbral& trabajo, int indiceSalida, PoolHilos* pool);
+
+    int numTeselas() const { return columnas * filas; }
+
+private:
+    int ancho, alto, tamano;
+    int columnas, filas;
+    std::vector<unsigned char> cambio;         // por tesela: cambió respecto del cuadro anterior
+    std::vector<unsigned char> cambioAnterior; // lo mismo, un cuadro antes
+    int umbralSalida[2] = {-1, -1};            // umbral con que se calculó cada buffer de salida; -1 si ninguno
+    bool conHistograma;
+    std::vector<uint32_t> histogramas;         // 256 contadores por tesela
+    size_t total[256] = {};
+};
+
+#endif
@@ -0,0 +1,93 @@
+#include <iostream>
+#include <fstream>
+#include <vector>
+#include <mutex>
+#include <chrono>
+#include <unistd.h>
+#include <sys/syscall.h>
+
+#include "traza.h"
+
+using namespace std;
+
+atomic<bool> trazaActiva(false);
+
+static mutex mtxEventos;
+static vector<EventoTraza> eventos;
+static int64_t inicioTrazaNs = 0;
+
+int64_t relojTrazaNs() {
+    return chrono::duration_cast<chrono::nanoseconds>(chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// El identificador del hilo para el sistema, el mismo que muestran top o perf; se guarda porque cambia solo con fork
+static int hiloActual() {
+    thread_local int tid = 0;
+    thread_local int pid = 0;
+    if (pid != getpid()) {
+        pid = getpid();
+        tid = static_cast<int>(syscall(SYS_gettid));
+    }
+    return tid;
+}
+
+void activarTraza() {
+    lock_guard<mutex> lock(mtxEventos);
+    inicioTrazaNs = relojTrazaNs();
+    trazaActiva = true;
+}
+
+void agregarEventoTraza(const EventoTraza& evento) {
+    lock_guard<mutex> lock(mtxEventos);
+    eventos.push_back(evento);
+}
+
+IntervaloTraza::IntervaloTraza(const char* nombre, const char* categoria, const char* nombreArgumento,
+                               int64_t argumento)
+    : datos(), activo(trazaActivada()) {
+    if (!activo) return;
+    datos = EventoTraza{nombre, categoria, relojTrazaNs(), 0, getpid(), hiloActual(), nombreArgumento, argumento};
+}
+
+EventoTraza IntervaloTraza::tomar() {
+    activo = false;
+    EventoTraza completo = datos;
+    completo.duracionNs = relojTrazaNs() - datos.inicioNs;
+    return completo;
+}
+
+void IntervaloTraza::terminar() {
+    if (!activo) return;
+    agregarEventoTraza(tomar());
+}
+
+bool escribirTraza(const string& ruta) {
+    lock_guard<mutex> lock(mtxEventos);
+    ofstream archivo(ruta);
+    if (!archivo) {
+        cerr << "No se pudo crear la traza: " << ruta << endl;
+        return false;
+    }
+    // Eventos completos ("X") con tiempos en microsegundos desde que se activó la traza
+    archivo << "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n";
+    archivo << "  {\"name\": \"process_name\", \"ph\": \"M\", \"pid\": " << getpid()
+            << ", \"tid\": 0, \"args\": {\"name\": \"umbralizar\"}}";
+    archivo.precision(3);
+    archivo << fixed;
+    for (const EventoTraza& evento : eventos) {
+        archivo << ",\n  {\"name\": \"" << evento.nombre << "\", \"cat\": \"" << evento.categoria
+                << "\", \"ph\": \"X\", \"ts\": " << (evento.inicioNs - inicioTrazaNs) / 1000.0
+                << ", \"dur\": " << evento.duracionNs / 1000.0 << ", \"pid\": " << evento.pid
+                << ", \"tid\": " << evento.tid;
+        if (evento.nombreArgumento != nullptr) {
+            archivo << ", \"args\": {\"" << evento.nombreArgumento << "\": " << evento.argumento << "}";
+        }
+        archivo << "}";
+    }
+    archivo << "\n]}\n";
+    if (!archivo) {
+        cerr << "Error al escribir la traza: " << ruta << endl;
+        return false;
+    }
+    return true;
+}
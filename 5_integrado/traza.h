@@ -0,0 +1,56 @@
+// Traza de eventos en el formato de Chrome (chrome://tracing, Perfetto): un intervalo por fase de cada imagen, por bloque
+// de filas que umbraliza cada hilo o proceso y por cada llamada de lectura o escritura del archivo, con el hilo que lo
+// hizo. Sirve para ver el desbalance entre hilos, los huecos y lo que queda en serie (como la escritura después del
+// umbralizado en paralelo).
+//
+// Mientras no se active no se registra nada y cada intervalo cuesta una lectura atómica.
+
+#ifndef TRAZA_H
+#define TRAZA_H
+
+#include <cstdint>
+#include <atomic>
+#include <string>
+
+// Sin punteros a memoria dinámica (los nombres son literales), para que un proceso hijo lo pueda dejar en memoria
+// compartida y el padre lo agregue
+struct EventoTraza {
+    const char* nombre;
+    const char* categoria;
+    int64_t inicioNs;   // del reloj monótono, el mismo en todos los procesos
+    int64_t duracionNs;
+    int pid;
+    int tid;
+    const char* nombreArgumento; // nulo si no tiene
+    int64_t argumento;
+};
+
+extern std::atomic<bool> trazaActiva;
+
+void activarTraza();
+inline bool trazaActivada() { return trazaActiva.load(std::memory_order_relaxed); }
+int64_t relojTrazaNs();
+void agregarEventoTraza(const EventoTraza& evento);
+// Escribe todos los eventos registrados hasta ahora como JSON
+bool escribirTraza(const std::string& ruta);
+
+// Registra un intervalo desde que se crea hasta que se destruye (o hasta terminar), en el hilo actual
+class IntervaloTraza {
+public:
+    IntervaloTraza(const char* nombre, const char* categoria, const char* nombreArgumento = nullptr,
+                   int64_t argumento = 0);
+    ~IntervaloTraza() { terminar(); }
+    IntervaloTraza(const IntervaloTraza&) = delete;
+    IntervaloTraza& operator=(const IntervaloTraza&) = delete;
+
+    void terminar();
+    // Termina el intervalo y lo devuelve en lugar de registrarlo, para que lo registre otro proceso (en un hijo de fork
+    // no se puede tomar el mutex del registro, que otro hilo del padre podía tener tomado)
+    EventoTraza tomar();
+
+private:
+    EventoTraza datos;
+    bool activo;
+};
+
+#endif
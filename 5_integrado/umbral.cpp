@@ -0,0 +1,331 @@
+// Implementación de la API en C (umbral.h) sobre el núcleo en C++. Aquí se validan los argumentos y se convierten las
+// excepciones en códigos de error, para que nunca crucen la frontera con C.
+
+#include <new>
+#include <cstdlib>
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <cstring>
+#include <cerrno>
+#include <unistd.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+#include "umbral.h"
+#include "nucleo.h"
+#include "backends.h"
+#include "lote.h"
+#include "compartida.h"
+#include "sesion.h"
+
+using namespace std;
+
+static bool formatoValido(umbral_formato formato) {
+    return formato >= UMBRAL_FORMATO_BGR24 && formato <= UMBRAL_FORMATO_GRIS8;
+}
+
+static int validarBuffer(const umbral_buffer* buffer) {
+    if (buffer == nullptr || buffer->datos == nullptr || buffer->ancho <= 0 || buffer->alto <= 0) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    if (!formatoValido(buffer->formato)) {
+        return UMBRAL_ERROR_FORMATO;
+    }
+    if (llabs(buffer->paso) < static_cast<long long>(buffer->ancho) * bytesPorPixel(buffer->formato)) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    return UMBRAL_OK;
+}
+
+static bool opcionesValidas(const umbral_opciones* opciones) {
+    return opciones->hilos >= 0 && opciones->filas_por_bloque >= 0 &&
+           (opciones->kernel == UMBRAL_KERNEL_ESCALAR || opciones->kernel == UMBRAL_KERNEL_TABLA);
+}
+
+static int segmentoAMensaje(const umbral_segmento* segmento, SegmentoMensaje& mensaje) {
+    if (segmento == nullptr || segmento->fd < 0) return UMBRAL_ERROR_ARGUMENTO;
+    if (!formatoValido(segmento->formato)) return UMBRAL_ERROR_FORMATO;
+    mensaje = SegmentoMensaje{segmento->desplazamiento, segmento->ancho, segmento->alto, segmento->paso,
+                              segmento->formato};
+    // Sin el tamaño del segmento no se puede saber si la imagen cabe; eso lo comprueba el servidor
+    return segmentoCabe(mensaje, SIZE_MAX) ? UMBRAL_OK : UMBRAL_ERROR_ARGUMENTO;
+}
+
+struct umbral_sesion {
+    explicit umbral_sesion(const umbral_buffer& entrada) : sesion(entrada) {}
+    SesionUmbral sesion;
+};
+
+extern "C" {
+
+void umbral_opciones_por_defecto(umbral_opciones* opciones) {
+    if (opciones == nullptr) return;
+    opciones->backend = UMBRAL_BACKEND_AUTO;
+    opciones->hilos = 0;
+    opciones->kernel = UMBRAL_KERNEL_ESCALAR;
+    opciones->filas_por_bloque = 0;
+}
+
+int umbral_cargar_perfil(const char* ruta) {
+    if (ruta == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    try {
+        return cargarPerfil(ruta) ? UMBRAL_OK : UMBRAL_ERROR_ARCHIVO;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+int umbral_procesar(const umbral_buffer* entrada, umbral_buffer* salida, unsigned char umbral,
+                    const umbral_opciones* opciones) {
+    int estado = validarBuffer(entrada);
+    if (estado == UMBRAL_OK) estado = validarBuffer(salida);
+    if (estado != UMBRAL_OK) return estado;
+
+    if (salida->ancho != entrada->ancho || salida->alto != entrada->alto) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    if (salida->formato != entrada->formato && salida->formato != UMBRAL_FORMATO_GRIS8) {
+        return UMBRAL_ERROR_FORMATO;
+    }
+
+    umbral_opciones porDefecto;
+    umbral_opciones_por_defecto(&porDefecto);
+    if (opciones == nullptr) opciones = &porDefecto;
+    if (!opcionesValidas(opciones)) return UMBRAL_ERROR_ARGUMENTO;
+
+    try {
+        TrabajoUmbral trabajo{*entrada, *salida, umbral, opciones->kernel, opciones->filas_por_bloque};
+        return ejecutarBackend(opciones->backend, trabajo, opciones->hilos);
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+int umbral_histograma(const umbral_buffer* entrada, unsigned long long histograma[256]) {
+    int estado = validarBuffer(entrada);
+    if (estado != UMBRAL_OK) return estado;
+    if (histograma == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+
+    size_t cuentas[256];
+    calcularHistograma(*entrada, cuentas);
+    for (int t = 0; t < 256; ++t) {
+        histograma[t] = cuentas[t];
+    }
+    return UMBRAL_OK;
+}
+
+int umbral_calcular(const umbral_buffer* entrada, const char* metodo, unsigned char* umbral) {
+    int estado = validarBuffer(entrada);
+    if (estado != UMBRAL_OK) return estado;
+    if (metodo == nullptr || umbral == nullptr || !esMetodoValido(metodo)) return UMBRAL_ERROR_ARGUMENTO;
+
+    *umbral = resolverUmbral(*entrada, metodo);
+    return UMBRAL_OK;
+}
+
+int umbral_procesar_lote(const char* manifiesto, const umbral_opciones* opciones, const char* directorio_cache,
+                         unsigned long long cache_max_bytes, int* fallos) {
+    if (manifiesto == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+
+    umbral_opciones porDefecto;
+    umbral_opciones_por_defecto(&porDefecto);
+    if (opciones == nullptr) opciones = &porDefecto;
+    if (!opcionesValidas(opciones)) return UMBRAL_ERROR_ARGUMENTO;
+
+    try {
+        vector<Trabajo> trabajos;
+        if (!leerManifiesto(manifiesto, trabajos)) {
+            return UMBRAL_ERROR_ARCHIVO;
+        }
+        unique_ptr<CacheResultados> cache;
+        if (directorio_cache != nullptr) {
+            cache.reset(new CacheResultados(directorio_cache, cache_max_bytes));
+        }
+        int numHilos = opciones->hilos > 0 ? opciones->hilos : nucleosDisponibles();
+        Ejecucion ejecucion{opciones->backend, numHilos, nullptr, opciones->kernel, opciones->filas_por_bloque};
+        int fallidas = procesarLote(trabajos, ejecucion, cache.get());
+        if (fallos != nullptr) *fallos = fallidas;
+        return UMBRAL_OK;
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+int umbral_crear_segmento(size_t bytes, int* fd) {
+    if (fd == nullptr || bytes == 0) return UMBRAL_ERROR_ARGUMENTO;
+    int descriptor = memfd_create("umbral", MFD_CLOEXEC | MFD_ALLOW_SEALING);
+    if (descriptor < 0) return UMBRAL_ERROR_SISTEMA;
+    if (ftruncate(descriptor, bytes) != 0) {
+        close(descriptor);
+        return UMBRAL_ERROR_MEMORIA;
+    }
+    // Sin este sello el servidor no acepta el segmento: nadie puede achicarlo mientras está mapeado
+    if (fcntl(descriptor, F_ADD_SEALS, F_SEAL_SHRINK | F_SEAL_SEAL) != 0) {
+        close(descriptor);
+        return UMBRAL_ERROR_SISTEMA;
+    }
+    *fd = descriptor;
+    return UMBRAL_OK;
+}
+
+int umbral_conectar(const char* ruta, int* conexion) {
+    sockaddr_un direccion{};
+    if (ruta == nullptr || conexion == nullptr || strlen(ruta) >= sizeof(direccion.sun_path)) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    direccion.sun_family = AF_UNIX;
+    strcpy(direccion.sun_path, ruta);
+    int descriptor = socket(AF_UNIX, SOCK_SEQPACKET | SOCK_CLOEXEC, 0);
+    if (descriptor < 0) return UMBRAL_ERROR_SISTEMA;
+    if (connect(descriptor, reinterpret_cast<sockaddr*>(&direccion), sizeof(direccion)) != 0) {
+        close(descriptor);
+        return UMBRAL_ERROR_SISTEMA;
+    }
+    *conexion = descriptor;
+    return UMBRAL_OK;
+}
+
+int umbral_enviar(int conexion, const umbral_segmento* entrada, const umbral_segmento* salida, const char* metodo,
+                  const umbral_opciones* opciones, unsigned char* umbral_usado) {
+    MensajeTrabajo mensaje{};
+    int estado = segmentoAMensaje(entrada, mensaje.entrada);
+    if (estado == UMBRAL_OK) estado = segmentoAMensaje(salida, mensaje.salida);
+    if (estado != UMBRAL_OK) return estado;
+    if (metodo == nullptr || strlen(metodo) >= sizeof(mensaje.metodo) || !esMetodoValido(metodo)) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    strcpy(mensaje.metodo, metodo);
+
+    umbral_opciones porDefecto;
+    umbral_opciones_por_defecto(&porDefecto);
+    if (opciones == nullptr) opciones = &porDefecto;
+    if (!opcionesValidas(opciones)) return UMBRAL_ERROR_ARGUMENTO;
+    mensaje.backend = opciones->backend;
+    mensaje.hilos = opciones->hilos;
+    mensaje.kernel = opciones->kernel;
+    mensaje.filasPorBloque = opciones->filas_por_bloque;
+
+    int descriptores[2] = {entrada->fd, salida->fd};
+    if (!enviarConDescriptores(conexion, &mensaje, sizeof(mensaje), descriptores, 2)) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+    RespuestaTrabajo respuesta;
+    int numDescriptores;
+    if (!recibirConDescriptores(conexion, &respuesta, sizeof(respuesta), nullptr, 0, numDescriptores)) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+    if (umbral_usado != nullptr) *umbral_usado = respuesta.umbral;
+    return respuesta.estado;
+}
+
+int umbral_sesion_crear(const umbral_buffer* entrada, umbral_sesion** sesion) {
+    int estado = validarBuffer(entrada);
+    if (estado != UMBRAL_OK) return estado;
+    if (sesion == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    try {
+        *sesion = new umbral_sesion(*entrada);
+        return UMBRAL_OK;
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+int umbral_sesion_abrir(const char* ruta, umbral_sesion** sesion) {
+    if (ruta == nullptr || sesion == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    try {
+        Imagen imagen;
+        if (!leerArchivoBMP(ruta, imagen)) return UMBRAL_ERROR_ARCHIVO;
+        umbral_buffer buffer = bufferDeImagen(imagen);
+        return umbral_sesion_crear(&buffer, sesion);
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+void umbral_sesion_destruir(umbral_sesion* sesion) {
+    delete sesion;
+}
+
+int umbral_sesion_dimensiones(const umbral_sesion* sesion, int* ancho, int* alto) {
+    if (sesion == nullptr || ancho == nullptr || alto == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    *ancho = sesion->sesion.ancho();
+    *alto = sesion->sesion.alto();
+    return UMBRAL_OK;
+}
+
+int umbral_sesion_histograma(const umbral_sesion* sesion, unsigned long long histograma[256]) {
+    if (sesion == nullptr || histograma == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    copy(sesion->sesion.histograma(), sesion->sesion.histograma() + 256, histograma);
+    return UMBRAL_OK;
+}
+
+int umbral_sesion_calcular(const umbral_sesion* sesion, const char* metodo, unsigned char* umbral) {
+    if (sesion == nullptr || metodo == nullptr || umbral == nullptr || !esMetodoValido(metodo)) {
+        return UMBRAL_ERROR_ARGUMENTO;
+    }
+    string nombre = metodo;
+    *umbral = nombre == "otsu" || nombre == "media" ? umbralDeHistograma(sesion->sesion.histograma(), nombre)
+                                                    : static_cast<unsigned char>(stoi(nombre));
+    return UMBRAL_OK;
+}
+
+int umbral_sesion_region(umbral_sesion* sesion, int x, int y, umbral_buffer* salida, unsigned char umbral,
+                         const umbral_opciones* opciones) {
+    int estado = validarBuffer(salida);
+    if (estado != UMBRAL_OK) return estado;
+    if (sesion == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+
+    umbral_opciones porDefecto;
+    umbral_opciones_por_defecto(&porDefecto);
+    if (opciones == nullptr) opciones = &porDefecto;
+    if (!opcionesValidas(opciones)) return UMBRAL_ERROR_ARGUMENTO;
+    try {
+        return sesion->sesion.umbralizarRegion(x, y, *salida, umbral, opciones->backend, opciones->hilos,
+                                               opciones->kernel);
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+int umbral_sesion_vista_previa(umbral_sesion* sesion, int factor, umbral_buffer* salida, unsigned char umbral) {
+    int estado = validarBuffer(salida);
+    if (estado != UMBRAL_OK) return estado;
+    if (sesion == nullptr) return UMBRAL_ERROR_ARGUMENTO;
+    try {
+        return sesion->sesion.vistaPrevia(factor, *salida, umbral);
+    } catch (const bad_alloc&) {
+        return UMBRAL_ERROR_MEMORIA;
+    } catch (...) {
+        return UMBRAL_ERROR_SISTEMA;
+    }
+}
+
+const char* umbral_mensaje(int estado) {
+    switch (estado) {
+        case UMBRAL_OK: return "correcto";
+        case UMBRAL_ERROR_ARGUMENTO: return "argumento inválido";
+        case UMBRAL_ERROR_FORMATO: return "formato no soportado";
+        case UMBRAL_ERROR_BACKEND: return "backend no disponible";
+        case UMBRAL_ERROR_SISTEMA: return "error del sistema";
+        case UMBRAL_ERROR_MEMORIA: return "memoria insuficiente";
+        case UMBRAL_ERROR_ARCHIVO: return "no se pudo leer el archivo";
+    }
+    return "error desconocido";
+}
+
+}
@@ -0,0 +1,174 @@
+/*
+API en C para umbralizar imágenes que ya están en memoria, sin pasar por archivos BMP.
+
+Los buffers de entrada y salida pertenecen a quien llama: la biblioteca no copia la imagen ni reserva memoria para ella
+(salvo el backend de procesos, que necesita un buffer compartido entre procesos). Ninguna función termina el programa;
+todos los errores se devuelven como un código umbral_estado.
+
+Compilar como biblioteca compartida:
+    g++ -O2 -fopenmp -fPIC -shared nucleo.cpp backends.cpp lote.cpp compartida.cpp sesion.cpp contadores.cpp traza.cpp memoria.cpp umbral.cpp -o libumbral.so
+*/
+
+#ifndef UMBRAL_H
+#define UMBRAL_H
+
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+    UMBRAL_FORMATO_BGR24 = 0,  /* 3 bytes por píxel en orden azul, verde, rojo (como en BMP) */
+    UMBRAL_FORMATO_RGB24 = 1,  /* 3 bytes por píxel en orden rojo, verde, azul */
+    UMBRAL_FORMATO_BGRA32 = 2, /* 4 bytes por píxel; el canal alfa se copia sin cambios */
+    UMBRAL_FORMATO_GRIS8 = 3   /* 1 byte por píxel */
+} umbral_formato;
+
+typedef enum {
+    UMBRAL_BACKEND_SECUENCIAL = 0,
+    UMBRAL_BACKEND_HILOS = 1,    /* pool de hilos compartido por todas las llamadas con el mismo número de hilos */
+    UMBRAL_BACKEND_PROCESOS = 2, /* fork(); evitarlo si el programa que llama tiene otros hilos con bloqueos tomados */
+    UMBRAL_BACKEND_OPENMP = 3,   /* solo si la biblioteca se compiló con -fopenmp */
+    UMBRAL_BACKEND_AUTO = 4      /* el de menor costo estimado según tamaño, formato, núcleos y memoria libre */
+} umbral_backend;
+
+typedef enum {
+    UMBRAL_KERNEL_ESCALAR = 0, /* promedio con división y comparación por píxel, como en las carpetas 1 a 4 */
+    UMBRAL_KERNEL_TABLA = 1    /* tabla precalculada indexada por la suma de canales; mismo resultado */
+} umbral_kernel;
+
+typedef enum {
+    UMBRAL_OK = 0,
+    UMBRAL_ERROR_ARGUMENTO = -1, /* puntero nulo, dimensiones o paso inválidos */
+    UMBRAL_ERROR_FORMATO = -2,   /* formato desconocido o combinación entrada/salida no soportada */
+    UMBRAL_ERROR_BACKEND = -3,   /* backend desconocido o no disponible en esta compilación */
+    UMBRAL_ERROR_SISTEMA = -4,   /* falló fork, mmap u otra llamada al sistema */
+    UMBRAL_ERROR_MEMORIA = -5,
+    UMBRAL_ERROR_ARCHIVO = -6    /* no se pudo leer un archivo (por ejemplo el manifiesto de un lote) */
+} umbral_estado;
+
+/* Vista sobre una imagen en memoria. La fila i empieza en (char*)datos + i * paso. */
+typedef struct {
+    void* datos;
+    int ancho;
+    int alto;
+    ptrdiff_t paso; /* bytes entre el inicio de una fila y la siguiente; puede ser negativo */
+    umbral_formato formato;
+} umbral_buffer;
+
+typedef struct {
+    umbral_backend backend;
+    int hilos;            /* 0 = tantos como núcleos disponibles */
+    umbral_kernel kernel;
+    int filas_por_bloque; /* 0 = un bloque de alto / hilos filas por hilo */
+} umbral_opciones;
+
+/*
+Backend y número de hilos automáticos, kernel escalar y un bloque por hilo. Si hay un perfil cargado (ver
+umbral_cargar_perfil), con UMBRAL_BACKEND_AUTO se usa la configuración del perfil para el tamaño de la imagen.
+*/
+void umbral_opciones_por_defecto(umbral_opciones* opciones);
+
+/* Carga un perfil generado por "umbralizar autotune". Reemplaza el perfil cargado antes, si lo había. */
+int umbral_cargar_perfil(const char* ruta);
+
+/*
+Umbraliza entrada en salida: los píxeles cuyo promedio de canales es menor que umbral quedan en 0 y el resto en 255.
+
+salida debe tener las mismas dimensiones que entrada y el mismo formato o UMBRAL_FORMATO_GRIS8. Puede ser el mismo
+buffer que entrada (procesamiento en el lugar) si tiene el mismo formato y paso. opciones puede ser NULL.
+*/
+int umbral_procesar(const umbral_buffer* entrada, umbral_buffer* salida, unsigned char umbral,
+                    const umbral_opciones* opciones);
+
+/* Histograma del promedio de canales de cada píxel (o del valor, en GRIS8). */
+int umbral_histograma(const umbral_buffer* entrada, unsigned long long histograma[256]);
+
+/* Calcula el umbral con un método automático ("otsu" o "media") o interpreta un número entre 0 y 255. */
+int umbral_calcular(const umbral_buffer* entrada, const char* metodo, unsigned char* umbral);
+
+/*
+Procesa todas las imágenes BMP de un manifiesto ("<entrada.bmp> <salida.bmp> <umbral|otsu|media>" por línea) en un
+pool de hilos compartido. opciones->backend se usa para las imágenes grandes. Si directorio_cache no es NULL, los
+resultados se guardan ahí con un límite de cache_max_bytes. En fallos (puede ser NULL) se devuelve cuántas imágenes no
+se pudieron procesar; eso no cambia el código devuelto, que solo indica errores del manifiesto o de los argumentos.
+*/
+int umbral_procesar_lote(const char* manifiesto, const umbral_opciones* opciones, const char* directorio_cache,
+                         unsigned long long cache_max_bytes, int* fallos);
+
+/*
+Cliente del modo servidor ("umbralizar servidor <socket>"): en lugar de pasar un puntero, la imagen se deja en un
+segmento de memoria compartida y se envía su descriptor. El servidor mapea el segmento y escribe la salida en otro, sin
+copiar los píxeles. Los segmentos tienen que ser memfd sellados con F_SEAL_SHRINK, como los de umbral_crear_segmento;
+el servidor rechaza cualquier otro descriptor con UMBRAL_ERROR_ARGUMENTO. El paso tiene que ser positivo.
+*/
+typedef struct {
+    int fd;                 /* descriptor del segmento; sigue perteneciendo a quien llama */
+    size_t desplazamiento;  /* bytes desde el inicio del segmento hasta la primera fila */
+    int ancho;
+    int alto;
+    ptrdiff_t paso;
+    umbral_formato formato;
+} umbral_segmento;
+
+/*
+Crea un segmento anónimo de bytes bytes con memfd_create, sellado para que no se pueda achicar (ni cambiar los sellos).
+Se mapea con mmap(..., MAP_SHARED, *fd, 0).
+*/
+int umbral_crear_segmento(size_t bytes, int* fd);
+
+/* Se conecta al socket de un servidor; la conexión se reutiliza para muchos trabajos y se cierra con close(). */
+int umbral_conectar(const char* ruta, int* conexion);
+
+/*
+Pide al servidor umbralizar entrada en salida y espera la respuesta. metodo es un número entre 0 y 255 u "otsu" o
+"media"; si umbral_usado no es NULL se devuelve ahí el umbral aplicado. Entrada y salida pueden ser el mismo segmento
+con las mismas reglas que en umbral_procesar. Devuelve el estado del servidor, o UMBRAL_ERROR_SISTEMA si se perdió la
+conexión.
+*/
+int umbral_enviar(int conexion, const umbral_segmento* entrada, const umbral_segmento* salida, const char* metodo,
+                  const umbral_opciones* opciones, unsigned char* umbral_usado);
+
+/*
+Sesión interactiva: la imagen se convierte a gris una vez y el plano gris y su histograma quedan en memoria, para
+volver a umbralizar regiones en milisegundos cada vez que cambia el umbral. La sesión no guarda referencias a la
+imagen original. Se pueden pedir regiones desde varios hilos a la vez.
+*/
+typedef struct umbral_sesion umbral_sesion;
+
+int umbral_sesion_crear(const umbral_buffer* entrada, umbral_sesion** sesion);
+
+/* Igual que umbral_sesion_crear con una imagen BMP leída de ruta. */
+int umbral_sesion_abrir(const char* ruta, umbral_sesion** sesion);
+
+void umbral_sesion_destruir(umbral_sesion* sesion);
+
+int umbral_sesion_dimensiones(const umbral_sesion* sesion, int* ancho, int* alto);
+
+/* Histograma calculado al crear la sesión; umbral_sesion_calcular lo usa sin volver a recorrer la imagen. */
+int umbral_sesion_histograma(const umbral_sesion* sesion, unsigned long long histograma[256]);
+int umbral_sesion_calcular(const umbral_sesion* sesion, const char* metodo, unsigned char* umbral);
+
+/*
+Umbraliza el rectángulo con esquina en (x, y) y del tamaño de salida, que tiene que ser GRIS8. Las filas se cuentan
+en el orden del buffer original (en un BMP, la primera fila es la de abajo). opciones puede ser NULL.
+*/
+int umbral_sesion_region(umbral_sesion* sesion, int x, int y, umbral_buffer* salida, unsigned char umbral,
+                         const umbral_opciones* opciones);
+
+/*
+Vista previa de baja resolución: umbraliza la imagen reducida factor veces en cada dirección (promedio por bloques) en
+salida, GRIS8 de (ancho + factor - 1) / factor por (alto + factor - 1) / factor. La imagen reducida se calcula la
+primera vez y se reutiliza mientras se pida el mismo factor.
+*/
+int umbral_sesion_vista_previa(umbral_sesion* sesion, int factor, umbral_buffer* salida, unsigned char umbral);
+
+/* Descripción legible de un código umbral_estado. */
+const char* umbral_mensaje(int estado);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,520 @@
+/*
+Versión integrada: un solo proceso que puede umbralizar muchas imágenes sin volver a lanzarse por cada una.
+
+Además del modo de una imagen (igual que las otras carpetas), admite un modo por lotes que lee un manifiesto con líneas
+"<entrada.bmp> <salida.bmp> <umbral|metodo>" y las procesa todas con un único pool de hilos compartido:
+
+- Las imágenes pequeñas se reparten entre los hilos del pool (una imagen por tarea), porque dividir una imagen pequeña
+  por filas cuesta más en sincronización de lo que se gana.
+- Las imágenes grandes se procesan una a una desde el hilo principal, dividiendo sus filas en bloques entre los hilos
+  del pool. Mientras tanto el hilo principal hace la lectura y escritura de disco de la siguiente.
+
+La matriz se guarda en un solo bloque contiguo (en lugar de vector<vector<Pixel>>) para poder reutilizar el buffer de
+una imagen a la siguiente sin volver a reservar memoria por cada fila.
+
+El umbral puede ser un número (0-255) o un método automático: "otsu" o "media".
+
+El umbralizado en sí está en nucleo.cpp, compartido con la biblioteca libumbral (ver umbral.h). Con --backend se elige
+cómo se reparten las imágenes grandes: secuencial, hilos, procesos u openmp, como en las carpetas 1 a 4.
+Por defecto (--backend auto) se elige el de menor costo estimado según el registro de backends.cpp, o la configuración
+medida por "umbralizar autotune" si existe un perfil (ver rutaPerfilPorDefecto en backends.cpp, o --perfil).
+
+Con --cache <directorio> los resultados se guardan en disco con una clave que depende de los píxeles de entrada y del
+umbral pedido. Si se vuelve a pedir lo mismo, la salida se copia de la cache sin umbralizar ni codificar de nuevo. El
+hash se calcula fila por fila mientras se lee la imagen, así que no hace falta una pasada extra. Cuando la cache supera
+--cache-max megabytes se borran las entradas usadas hace más tiempo.
+
+Con una imagen se muestra el tiempo de lectura, decodificación, umbralizado (y el de cada hilo o proceso), codificación
+y escritura. Con --contadores también los contadores de hardware de cada fase y de cada hilo (ver contadores.h). Con
+--memoria, las asignaciones de memoria dinámica, los fallos de página y el pico de memoria residente de cada fase (ver
+memoria.h).
+Con --metricas <archivo|-> cada imagen (también en el modo por lotes) agrega una fila en JSON lines o CSV con las
+mismas mediciones, para leerlas desde otros programas (ver metricas.h).
+Con --traza <archivo.json> se guarda una traza para chrome://tracing o Perfetto con un intervalo por fase, por bloque
+de filas de cada hilo o proceso y por cada lectura o escritura del archivo (ver traza.h).
+
+Con "servidor <socket>" atiende a procesos productores que ya tienen las imágenes en memoria: las dejan en memoria
+compartida y pasan el descriptor por un socket Unix (ver compartida.h y umbral_enviar en umbral.h), así que no hay que
+escribir ni leer un BMP por imagen.
+
+Con --prometheus <archivo> (servidor o lote) se reescribe cada --prometheus-intervalo segundos (10 por defecto) un
+archivo con métricas en el formato de texto de Prometheus: trabajos, bytes, histogramas de cada fase, trabajos
+pendientes y utilización de los hilos (ver exportador.h).
+
+Con "video" umbraliza cuadros sin comprimir concatenados (de un archivo o de la entrada estándar, con "-"), todos del
+mismo ancho, alto y formato. Los buffers se reutilizan entre cuadros y la escritura de cada cuadro se hace en otro hilo
+mientras se umbraliza el siguiente. Con cuadros YUV420p o NV12 se umbraliza directamente el plano Y, que ya es un byte
+por píxel, y la salida es un plano en blanco y negro. Con --teselas N solo se vuelven a umbralizar las teselas de NxN
+píxeles que cambiaron respecto del cuadro anterior (ver teselas.h); con otsu o media, también el histograma se actualiza
+solo con esas teselas. --suavizado P (entre 0 y 1) promedia exponencialmente el umbral automático entre cuadros para
+que no parpadee: cada cuadro aporta P y lo acumulado 1 - P.
+
+"bench" mide todos los backends y kernels sobre imágenes sintéticas de varios tamaños y resume los tiempos (mínimo,
+mediana, p95, desviación estándar) y el rendimiento; con --formato csv|json también los deja en un formato legible por
+programas.
+
+"micro" mide cada kernel solo (umbralizado escalar y con tabla en cada formato, gris escalar, SSE2, AVX2 y AVX-512
+según la compilación, conversión a gris, histograma y empaquetado de 1 bit) sobre buffers que entran en la caché, en
+nanosegundos y ciclos por píxel.
+
+"techo" mide el ancho de banda de memoria de la máquina (lectura, escritura y copia, como STREAM) con uno y con --hilos
+hilos, y cuánto de la copia alcanza cada backend umbralizando los mismos buffers.
+
+"escalado" mide los backends paralelos con 1 a --hilos hilos, con una imagen fija (escalado fuerte) y con una que crece
+con los hilos (escalado débil), e informa la aceleración y la eficiencia respecto del mismo backend con un hilo.
+
+"generar" escribe una imagen de prueba del tamaño pedido (también de decenas de gigapíxeles: las filas se generan y
+escriben por tandas) con un degradado, ruido, renglones de texto o las tres cosas en franjas. Con --formato distinto de
+bmp escribe los píxeles crudos, como los lee "video"; con "-" van a la salida estándar.
+
+"verificar" umbraliza imágenes generadas de tamaños incómodos (anchos impares, una fila, una columna, una grande) con
+todos los backends, kernels, formatos y cantidades de hilos y compara cada salida con una referencia escalar. Después
+mide el rendimiento de cada backend y, con --linea-base, lo compara con uno guardado antes con --guardar-linea-base.
+Termina con 1 si alguna salida difiere o si algún backend rinde menos que la línea base por más de --tolerancia.
+
+Con "varios" se aplican varios umbrales a una imagen leyéndola y convirtiéndola a gris una sola vez; cada umbral produce
+un BMP monocromo de 1 bit por píxel. La plantilla de salida lleva {} donde va el umbral (por ejemplo mascara_{}.bmp).
+*/
+
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+#include "nucleo.h"
+#include "backends.h"
+#include "lote.h"
+#include "autotune.h"
+#include "servidor.h"
+#include "video.h"
+#include "varios.h"
+#include "bench.h"
+#include "medicion.h"
+#include "metricas.h"
+#include "traza.h"
+#include "generador.h"
+#include "escalado.h"
+#include "verificar.h"
+#include "micro.h"
+#include "techo.h"
+#include "exportador.h"
+
+using namespace std;
+
+// Opciones que no llevan valor; quedan en opciones con el valor "1"
+const vector<string> OPCIONES_SIN_VALOR = {"contadores", "memoria", "guardar-linea-base"};
+
+// Separa los argumentos en posicionales y opciones de la forma --nombre valor
+void separarArgumentos(int argc, char* argv[], vector<string>& posicionales, map<string, string>& opciones) {
+    for (int i = 1; i < argc; ++i) {
+        string argumento = argv[i];
+        if (argumento.rfind("--", 0) == 0 &&
+            find(OPCIONES_SIN_VALOR.begin(), OPCIONES_SIN_VALOR.end(), argumento.substr(2)) != OPCIONES_SIN_VALOR.end()) {
+            opciones[argumento.substr(2)] = "1";
+        } else if (argumento.rfind("--", 0) == 0 && i + 1 < argc) {
+            opciones[argumento.substr(2)] = argv[++i];
+        } else {
+            posicionales.push_back(argumento);
+        }
+    }
+}
+
+void mostrarUso(const char* programa) {
+    cerr << "Uso: " << programa << " <nombre_del_archivo_entrada.bmp> <nombre_del_archivo_salida.bmp> <umbral|otsu|media>" << endl;
+    cerr << "     " << programa << " lote <manifiesto.txt>" << endl;
+    cerr << "     " << programa << " varios <entrada.bmp> <plantilla_salida_{}.bmp> <umbral|otsu|media>..." << endl;
+    cerr << "     " << programa << " servidor <socket> [--prometheus <archivo> [--prometheus-intervalo S]]" << endl;
+    cerr << "     " << programa << " video <entrada|-> <salida|-> <umbral|otsu|media> --ancho N --alto N"
+         << " [--formato bgr24|rgb24|bgra32|gris8|yuv420p|nv12] [--formato-salida gris8] [--teselas N] [--suavizado P]" << endl;
+    cerr << "     " << programa << " micro [--tamano 256x64] [--repeticiones N] [--formato csv|json] [--salida <archivo>]"
+         << endl;
+    cerr << "     " << programa << " techo [--hilos N] [--tamano 4096x4096] [--repeticiones N] [--formato csv|json]"
+         << " [--salida <archivo>]" << endl;
+    cerr << "     " << programa << " escalado [--hilos N] [--tamano 2048x2048] [--tamano-por-hilo 2048x256]"
+         << " [--repeticiones N] [--calentamiento N] [--formato csv|json] [--salida <archivo>]" << endl;
+    cerr << "     " << programa << " generar <salida|-> --ancho N --alto N [--patron degradado|ruido|texto|mixto]"
+         << " [--semilla N] [--formato bmp|bgr24|rgb24|bgra32|gris8]" << endl;
+    cerr << "     " << programa << " verificar [--hilos N] [--grande 4099x4097] [--tamano 2048x2048] [--repeticiones N]"
+         << " [--linea-base <archivo.csv> [--guardar-linea-base] [--tolerancia 0.2]]" << endl;
+    cerr << "     " << programa << " autotune [--perfil <ruta>] [--repeticiones N]" << endl;
+    cerr << "     " << programa << " bench [--tamanos 640x480,...] [--repeticiones N] [--calentamiento N]"
+         << " [--formato csv|json] [--salida <archivo>]" << endl;
+    cerr << "Opciones comunes: [--backend auto|secuencial|hilos|procesos|openmp] [--hilos N]" << endl;
+    cerr << "                  [--kernel escalar|tabla] [--filas-por-bloque N] [--perfil <ruta>]" << endl;
+    cerr << "                  [--cache <directorio>] [--cache-max <MB>]" << endl;
+    cerr << "Con una imagen:   [--contadores] [--memoria]" << endl;
+    cerr << "Con lote:         [--prometheus <archivo> [--prometheus-intervalo S]]" << endl;
+    cerr << "Con una imagen o lote: [--metricas <archivo|->] [--formato-metricas jsonl|csv] [--traza <archivo.json>]"
+         << endl;
+}
+
+// Los contadores de cada fase del hilo principal y los de cada hilo o proceso del backend
+void mostrarContadores(ostream& informe, const TiemposFases& tiempos, umbral_backend usado, size_t pixeles) {
+    string error = errorContadores();
+    LecturaContadores todos = tiempos.contadoresLectura;
+    todos += tiempos.contadoresUmbralizado;
+    bool alguno = false;
+    for (int c = 0; c < NUM_CONTADORES; ++c) alguno = alguno || todos.disponibles[c];
+    if (!alguno) {
+        informe << "contadores de hardware no disponibles" << (error.empty() ? "" : " (" + error + ")") << std::endl;
+        return;
+    }
+    if (!error.empty()) informe << "algunos contadores no están disponibles (" << error << ")" << std::endl;
+    informe << "contadores lectura y decodificación: " << resumenContadores(tiempos.contadoresLectura, pixeles) << std::endl;
+    informe << "contadores umbralizado: " << resumenContadores(tiempos.contadoresUmbralizado, pixeles) << std::endl;
+    // Cada hilo se divide por todos los píxeles para que los valores se puedan sumar entre hilos
+    for (size_t i = 0; i < tiempos.contadoresHilos.size(); ++i) {
+        informe << "  " << (usado == UMBRAL_BACKEND_PROCESOS ? "proceso " : "hilo ") << i << ": "
+                << resumenContadores(tiempos.contadoresHilos[i], pixeles) << std::endl;
+    }
+    informe << "contadores codificación y escritura: " << resumenContadores(tiempos.contadoresEscritura, pixeles)
+            << std::endl;
+}
+
+int main(int argc, char* argv[]) {
+    vector<string> posicionales;
+    map<string, string> opciones;
+    separarArgumentos(argc, argv, posicionales, opciones);
+
+    int numHilos = opciones.count("hilos") ? stoi(opciones["hilos"]) : nucleosDisponibles();
+    if (numHilos <= 0) numHilos = 1;
+
+    umbral_backend backend = UMBRAL_BACKEND_AUTO;
+    if (opciones.count("backend") && !backendPorNombre(opciones["backend"], backend)) {
+        cerr << "Backend desconocido: " << opciones["backend"] << endl;
+        mostrarUso(argv[0]);
+        return 1;
+    }
+
+    umbral_kernel kernel = UMBRAL_KERNEL_ESCALAR;
+    if (opciones.count("kernel") && !kernelPorNombre(opciones["kernel"], kernel)) {
+        cerr << "Kernel desconocido: " << opciones["kernel"] << endl;
+        mostrarUso(argv[0]);
+        return 1;
+    }
+    int filasPorBloque = opciones.count("filas-por-bloque") ? max(0, stoi(opciones["filas-por-bloque"])) : 0;
+
+    string rutaPerfil = opciones.count("perfil") ? opciones["perfil"] : rutaPerfilPorDefecto();
+    if (posicionales.size() == 1 && posicionales[0] == "autotune") {
+        int repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 5;
+        return ejecutarAutotune(rutaPerfil, repeticiones);
+    }
+    if (posicionales.size() == 1 && posicionales[0] == "bench") {
+        OpcionesBench bench;
+        bench.repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 10;
+        bench.calentamiento = opciones.count("calentamiento") ? max(0, stoi(opciones["calentamiento"])) : 2;
+        bench.numHilos = numHilos;
+        bench.formato = opciones.count("formato") ? opciones["formato"] : (opciones.count("salida") ? "csv" : "");
+        bench.salida = opciones.count("salida") ? opciones["salida"] : "";
+        string tamanos = opciones.count("tamanos") ? opciones["tamanos"] : "256x256,1024x768,1920x1080,4096x4096";
+        if (!leerTamanos(tamanos, bench.tamanos) || (bench.formato != "" && bench.formato != "csv" && bench.formato != "json")) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        return ejecutarBench(bench);
+    }
+    if (posicionales.size() == 1 && posicionales[0] == "micro") {
+        OpcionesMicro micro;
+        micro.repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 15;
+        micro.formato = opciones.count("formato") ? opciones["formato"] : (opciones.count("salida") ? "csv" : "");
+        micro.salida = opciones.count("salida") ? opciones["salida"] : "";
+        vector<pair<int, int>> tamano;
+        if (!leerTamanos(opciones.count("tamano") ? opciones["tamano"] : "256x64", tamano) || tamano.size() != 1 ||
+            (micro.formato != "" && micro.formato != "csv" && micro.formato != "json")) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        micro.tamano = tamano[0];
+        return ejecutarMicro(micro);
+    }
+    if (posicionales.size() == 1 && posicionales[0] == "techo") {
+        OpcionesTecho techo;
+        techo.numHilos = numHilos;
+        techo.repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 5;
+        techo.kernel = kernel;
+        techo.formato = opciones.count("formato") ? opciones["formato"] : (opciones.count("salida") ? "csv" : "");
+        techo.salida = opciones.count("salida") ? opciones["salida"] : "";
+        vector<pair<int, int>> tamano;
+        if (!leerTamanos(opciones.count("tamano") ? opciones["tamano"] : "4096x4096", tamano) || tamano.size() != 1 ||
+            (techo.formato != "" && techo.formato != "csv" && techo.formato != "json")) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        techo.tamano = tamano[0];
+        return ejecutarTecho(techo);
+    }
+    if (posicionales.size() == 1 && posicionales[0] == "escalado") {
+        OpcionesEscalado escalado;
+        escalado.maxHilos = numHilos;
+        escalado.repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 5;
+        escalado.calentamiento = opciones.count("calentamiento") ? max(0, stoi(opciones["calentamiento"])) : 1;
+        escalado.kernel = kernel;
+        escalado.formato = opciones.count("formato") ? opciones["formato"] : (opciones.count("salida") ? "csv" : "");
+        escalado.salida = opciones.count("salida") ? opciones["salida"] : "";
+        vector<pair<int, int>> fuerte, porHilo;
+        if (!leerTamanos(opciones.count("tamano") ? opciones["tamano"] : "2048x2048", fuerte) || fuerte.size() != 1 ||
+            !leerTamanos(opciones.count("tamano-por-hilo") ? opciones["tamano-por-hilo"] : "2048x256", porHilo) ||
+            porHilo.size() != 1 || (escalado.formato != "" && escalado.formato != "csv" && escalado.formato != "json")) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        escalado.tamanoFuerte = fuerte[0];
+        escalado.tamanoPorHilo = porHilo[0];
+        return ejecutarEscalado(escalado);
+    }
+    if (posicionales.size() == 1 && posicionales[0] == "verificar") {
+        OpcionesVerificar verificar;
+        verificar.numHilos = numHilos;
+        verificar.repeticiones = opciones.count("repeticiones") ? max(1, stoi(opciones["repeticiones"])) : 5;
+        verificar.lineaBase = opciones.count("linea-base") ? opciones["linea-base"] : "";
+        verificar.guardarLineaBase = opciones.count("guardar-linea-base") > 0;
+        verificar.tolerancia = opciones.count("tolerancia") ? stod(opciones["tolerancia"]) : 0.2;
+        vector<pair<int, int>> grande, rendimiento;
+        if (!leerTamanos(opciones.count("grande") ? opciones["grande"] : "4099x4097", grande) || grande.size() != 1 ||
+            !leerTamanos(opciones.count("tamano") ? opciones["tamano"] : "2048x2048", rendimiento) ||
+            rendimiento.size() != 1 || (verificar.guardarLineaBase && verificar.lineaBase.empty())) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        verificar.tamanoGrande = grande[0];
+        verificar.tamanoRendimiento = rendimiento[0];
+        return ejecutarVerificar(verificar);
+    }
+    if (posicionales.size() == 2 && posicionales[0] == "generar") {
+        OpcionesGenerador generador;
+        generador.ancho = opciones.count("ancho") ? stoi(opciones["ancho"]) : 0;
+        generador.alto = opciones.count("alto") ? stoi(opciones["alto"]) : 0;
+        generador.semilla = opciones.count("semilla") ? stoul(opciones["semilla"]) : 1;
+        generador.numHilos = numHilos;
+        string formato = opciones.count("formato") ? opciones["formato"] : "bmp";
+        generador.crudo = formato != "bmp";
+        if (generador.ancho <= 0 || generador.alto <= 0 ||
+            (opciones.count("patron") && !patronPorNombre(opciones["patron"], generador.patron)) ||
+            (generador.crudo && !formatoPorNombre(formato, generador.formato)) ||
+            (!generador.crudo && posicionales[1] == "-")) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+
+        // Si la imagen sale por la salida estándar, el informe va a la salida de errores
+        ostream& informe = posicionales[1] == "-" ? std::cerr : std::cout;
+        informe << std::endl << "MEDICIÓN DE FORMA GENERAR. .........." << std::endl;
+        auto start_time = std::chrono::high_resolution_clock::now();
+        bool correcto = generarImagen(posicionales[1], generador);
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+        informe << "tiempo generar: " << duracion.count() << std::endl;
+        return correcto ? 0 : 1;
+    }
+    // El perfil por defecto es opcional; uno pedido con --perfil tiene que poder cargarse
+    if (!cargarPerfil(rutaPerfil) && opciones.count("perfil")) {
+        cerr << "No se pudo cargar el perfil: " << rutaPerfil << endl;
+        return 1;
+    }
+    string rutaPrometheus = opciones.count("prometheus") ? opciones["prometheus"] : "";
+    double intervaloPrometheus = opciones.count("prometheus-intervalo") ? stod(opciones["prometheus-intervalo"]) : 10;
+    if (!(intervaloPrometheus > 0)) {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+    if (posicionales.size() == 2 && posicionales[0] == "servidor") {
+        if (rutaPrometheus.empty()) return ejecutarServidor(posicionales[1]);
+        // Las conexiones que siguen abiertas pueden registrar trabajos hasta que termine el proceso, así que el
+        // exportador no se destruye: solo se detiene
+        ExportadorMetricas* exportador = new ExportadorMetricas(rutaPrometheus, intervaloPrometheus, nucleosDisponibles());
+        int resultado = ejecutarServidor(posicionales[1], exportador);
+        exportador->detener();
+        return resultado;
+    }
+    Ejecucion ejecucion{backend, numHilos, nullptr, kernel, filasPorBloque};
+
+    if (posicionales.size() >= 4 && posicionales[0] == "varios") {
+        string plantilla = posicionales[2];
+        size_t marca = plantilla.find("{}");
+        if (marca == string::npos) {
+            cerr << "La plantilla de salida tiene que incluir {}: " << plantilla << endl;
+            return 1;
+        }
+        vector<string> metodos(posicionales.begin() + 3, posicionales.end());
+        vector<string> salidas;
+        for (const string& metodo : metodos) {
+            if (!esMetodoValido(metodo)) {
+                mostrarUso(argv[0]);
+                return 1;
+            }
+            salidas.push_back(string(plantilla).replace(marca, 2, metodo));
+        }
+
+        std::cout << std::endl << "MEDICIÓN DE FORMA VARIOS. .........." << std::endl;
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        vector<unsigned char> umbrales;
+        bool correcto = procesarVariosUmbrales(posicionales[1], metodos, salidas, ejecucion, &umbrales);
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+        std::cout << "umbrales:";
+        for (unsigned char umbral : umbrales) std::cout << " " << static_cast<int>(umbral);
+        std::cout << std::endl << "tiempo varios: " << duracion.count() << std::endl;
+        return correcto ? 0 : 1;
+    }
+
+    if (posicionales.size() == 4 && posicionales[0] == "video") {
+        OpcionesVideo video{0, 0, UMBRAL_FORMATO_BGR24, false, false, posicionales[3], ejecucion};
+        video.ancho = opciones.count("ancho") ? stoi(opciones["ancho"]) : 0;
+        video.alto = opciones.count("alto") ? stoi(opciones["alto"]) : 0;
+        video.tesela = opciones.count("teselas") ? max(0, stoi(opciones["teselas"])) : 0;
+        video.suavizado = opciones.count("suavizado") ? stod(opciones["suavizado"]) : 1;
+        umbral_formato formatoSalida = UMBRAL_FORMATO_BGR24;
+        if (video.ancho <= 0 || video.alto <= 0 || !esMetodoValido(video.metodo) ||
+            !(video.suavizado > 0 && video.suavizado <= 1) ||
+            (opciones.count("formato") && !formatoVideoPorNombre(opciones["formato"], video)) ||
+            (opciones.count("formato-salida") && !formatoPorNombre(opciones["formato-salida"], formatoSalida))) {
+            mostrarUso(argv[0]);
+            return 1;
+        }
+        if (opciones.count("formato-salida")) {
+            if (formatoSalida != video.formato && formatoSalida != UMBRAL_FORMATO_GRIS8) {
+                cerr << "El formato de salida tiene que ser gris8 o el de entrada" << endl;
+                return 1;
+            }
+            video.salidaGris = formatoSalida == UMBRAL_FORMATO_GRIS8;
+        }
+
+        // Si los cuadros salen por la salida estándar, el informe va a la salida de errores
+        ostream& informe = posicionales[2] == "-" ? std::cerr : std::cout;
+        informe << std::endl << "MEDICIÓN DE FORMA VIDEO. .........." << std::endl;
+        ResultadoVideo resultado;
+        bool correcto = procesarVideo(posicionales[1], posicionales[2], video, resultado);
+        informe << "cuadros: " << resultado.cuadros << std::endl;
+        if (video.tesela > 0) {
+            informe << "teselas umbralizadas: " << resultado.teselasUmbralizadas << "/" << resultado.teselas << std::endl;
+        }
+        informe << "fps: " << (resultado.segundos > 0 ? resultado.cuadros / resultado.segundos : 0) << std::endl;
+        informe << "tiempo video: " << static_cast<long long>(resultado.segundos * 1e6) << std::endl;
+        return correcto ? 0 : 1;
+    }
+
+    // Con --metricas - las métricas van a la salida estándar y el informe legible a la de errores
+    string rutaMetricas = opciones.count("metricas") ? opciones["metricas"] : "";
+    // Sin --formato-metricas, CSV si el archivo termina en .csv y JSON lines si no
+    string formatoMetricas = "jsonl";
+    if (opciones.count("formato-metricas")) {
+        formatoMetricas = opciones["formato-metricas"];
+    } else if (rutaMetricas.size() > 4 && rutaMetricas.compare(rutaMetricas.size() - 4, 4, ".csv") == 0) {
+        formatoMetricas = "csv";
+    }
+    if (formatoMetricas != "jsonl" && formatoMetricas != "csv") {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+    ostream& informe = rutaMetricas == "-" ? std::cerr : std::cout;
+
+    unique_ptr<CacheResultados> cache;
+    if (opciones.count("cache")) {
+        uintmax_t megabytes = opciones.count("cache-max") ? stoull(opciones["cache-max"]) : 1024;
+        cache.reset(new CacheResultados(opciones["cache"], megabytes * 1024 * 1024));
+    }
+
+    string rutaTraza = opciones.count("traza") ? opciones["traza"] : "";
+    if (!rutaTraza.empty()) activarTraza();
+
+    if (posicionales.size() == 2 && posicionales[0] == "lote") {
+        vector<Trabajo> trabajos;
+        if (!leerManifiesto(posicionales[1].c_str(), trabajos)) {
+            return 1;
+        }
+
+        informe << std::endl << "MEDICIÓN DE FORMA LOTES. .........." << std::endl;
+        auto start_time = std::chrono::high_resolution_clock::now();
+
+        vector<MedicionTrabajo> mediciones;
+        unique_ptr<ExportadorMetricas> exportador;
+        function<void(const MedicionTrabajo&)> alTerminar;
+        if (!rutaPrometheus.empty()) {
+            exportador.reset(new ExportadorMetricas(rutaPrometheus, intervaloPrometheus, numHilos));
+            exportador->trabajosRecibidos(trabajos.size());
+            alTerminar = [&](const MedicionTrabajo& medicion) { exportador->trabajoTerminado(medicion); };
+        }
+        int fallos = procesarLote(trabajos, ejecucion, cache.get(), rutaMetricas.empty() ? nullptr : &mediciones,
+                                  alTerminar);
+        exportador.reset();
+        if (!rutaTraza.empty() && !escribirTraza(rutaTraza)) return 1;
+
+        auto end_time = std::chrono::high_resolution_clock::now();
+        auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+        informe << "imágenes: " << trabajos.size() - fallos << "/" << trabajos.size() << std::endl;
+        informe << "tiempo lotes: "<< duracion.count() << std::endl;
+        if (!rutaMetricas.empty()) {
+            InformeMetricas metricas;
+            for (size_t i = 0; i < trabajos.size(); ++i) metricas.agregar("lote", trabajos[i], mediciones[i]);
+            if (!metricas.escribir(rutaMetricas, formatoMetricas)) return 1;
+        }
+        return fallos == 0 ? 0 : 1;
+    }
+
+    if (posicionales.size() != 3 || !esMetodoValido(posicionales[2])) {
+        mostrarUso(argv[0]);
+        return 1;
+    }
+
+    informe << std::endl << "MEDICIÓN DE FORMA INTEGRADA. .........." << std::endl;
+    auto start_time = std::chrono::high_resolution_clock::now();
+
+    // Leer, umbralizar y guardar
+    Trabajo trabajo{posicionales[0], posicionales[1], posicionales[2]};
+    Imagen imagen;
+    MedicionTrabajo medicion;
+    medicion.backend = backend;
+    TiemposFases& tiempos = medicion.tiempos;
+    tiempos.conContadores = opciones.count("contadores") > 0;
+    LecturaMemoria memoriaInicial = leerMemoria();
+    bool correcto = procesarTrabajo(trabajo, imagen, ejecucion, cache.get(), &medicion.backend, &tiempos);
+    if (!rutaTraza.empty() && !escribirTraza(rutaTraza)) return 1;
+    if (!correcto) {
+        return 1;
+    }
+    umbral_backend usado = medicion.backend;
+    medicion.memoria = diferenciaMemoria(memoriaInicial, leerMemoria());
+
+    auto end_time = std::chrono::high_resolution_clock::now();
+    auto duracion = std::chrono::duration_cast<std::chrono::microseconds> (end_time-start_time);
+    informe << "backend: " << nombreBackend(usado) << (backend == UMBRAL_BACKEND_AUTO ? " (auto)" : "") << std::endl;
+    // Con la caché, si el resultado ya existía no hay umbralizado ni escritura
+    informe << "tiempo lectura: " << static_cast<long long>(tiempos.lectura) << std::endl;
+    informe << "tiempo decodificación: " << static_cast<long long>(tiempos.decodificacion) << std::endl;
+    informe << "tiempo umbralizado: " << static_cast<long long>(tiempos.umbralizado) << std::endl;
+    for (size_t i = 0; i < tiempos.hilos.size(); ++i) {
+        informe << "  " << (usado == UMBRAL_BACKEND_PROCESOS ? "proceso " : "hilo ") << i << ": "
+                << static_cast<long long>(tiempos.hilos[i]) << std::endl;
+    }
+    informe << "tiempo codificación: " << static_cast<long long>(tiempos.codificacion) << std::endl;
+    informe << "tiempo escritura: " << static_cast<long long>(tiempos.escritura) << std::endl;
+    if (tiempos.conContadores) {
+        mostrarContadores(informe, tiempos, usado, imagen.numPixeles());
+    }
+    if (opciones.count("memoria")) {
+        informe << "memoria lectura y decodificación: " << resumenMemoria(tiempos.memoriaLectura) << std::endl;
+        informe << "memoria umbralizado: " << resumenMemoria(tiempos.memoriaUmbralizado) << std::endl;
+        informe << "memoria codificación y escritura: " << resumenMemoria(tiempos.memoriaEscritura) << std::endl;
+        informe << "memoria total: " << resumenMemoria(medicion.memoria) << std::endl;
+    }
+    informe << "tiempo integrado: "<< duracion.count() << std::endl;
+
+    if (!rutaMetricas.empty()) {
+        medicion.correcto = true;
+        medicion.ancho = imagen.ancho;
+        medicion.alto = imagen.alto;
+        medicion.totalUs = duracion.count();
+        InformeMetricas metricas;
+        metricas.agregar("integrado", trabajo, medicion);
+        if (!metricas.escribir(rutaMetricas, formatoMetricas)) return 1;
+    }
+
+    return 0;
+}
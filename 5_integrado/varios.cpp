@@ -0,0 +1,78 @@
+#include <iostream>
+#include <algorithm>
+
+#include "varios.h"
+
+using namespace std;
+
+bool procesarVariosUmbrales(const string& entrada, const vector<string>& metodos, const vector<string>& salidas,
+                            const Ejecucion& ejecucion, vector<unsigned char>* umbrales) {
+    Imagen imagen;
+    if (!leerArchivoBMP(entrada.c_str(), imagen)) {
+        return false;
+    }
+    int ancho = imagen.ancho, alto = imagen.alto;
+    size_t bytesFila = bytesFilaBits(ancho);
+    vector<unsigned char> gris(imagen.numPixeles());
+    vector<vector<unsigned char>> mascaras(metodos.size(), vector<unsigned char>(bytesFila * alto));
+
+    // Las imágenes grandes se reparten por franjas en el pool, salvo con el backend secuencial
+    int numFranjas = 1;
+    if (ejecucion.backend != UMBRAL_BACKEND_SECUENCIAL && imagen.numPixeles() >= PIXELES_IMAGEN_GRANDE) {
+        numFranjas = min(ejecucion.numHilos, alto);
+    }
+    PoolHilos* pool = ejecucion.pool;
+    if (pool == nullptr && numFranjas > 1) pool = &poolCompartido(ejecucion.numHilos);
+    auto repartir = [&](const function<void(int, int)>& tarea) {
+        auto franja = [&](int k) {
+            tarea(static_cast<long long>(alto) * k / numFranjas, static_cast<long long>(alto) * (k + 1) / numFranjas);
+        };
+        if (numFranjas == 1) {
+            franja(0);
+        } else {
+            pool->ejecutarEnParalelo(numFranjas, franja);
+        }
+    };
+
+    // Una sola conversión a gris para todos los umbrales
+    umbral_buffer color = bufferDeImagen(imagen);
+    repartir([&](int inicio, int fin) {
+        for (int i = inicio; i < fin; ++i) {
+            convertirFilaAGris(filaBuffer(color, i), &gris[static_cast<size_t>(i) * ancho], ancho, sizeof(Pixel));
+        }
+    });
+
+    // El histograma solo hace falta si algún umbral es automático
+    vector<unsigned char> valores;
+    size_t histograma[256];
+    bool conHistograma = false;
+    for (const string& metodo : metodos) {
+        if (metodo == "otsu" || metodo == "media") {
+            if (!conHistograma) {
+                umbral_buffer plano{gris.data(), ancho, alto, static_cast<ptrdiff_t>(ancho), UMBRAL_FORMATO_GRIS8};
+                calcularHistograma(plano, histograma);
+                conHistograma = true;
+            }
+            valores.push_back(umbralDeHistograma(histograma, metodo));
+        } else {
+            valores.push_back(static_cast<unsigned char>(stoi(metodo)));
+        }
+    }
+
+    // Cada fila gris se empaqueta para todos los umbrales mientras sigue en caché
+    repartir([&](int inicio, int fin) {
+        for (int i = inicio; i < fin; ++i) {
+            const unsigned char* fila = &gris[static_cast<size_t>(i) * ancho];
+            for (size_t k = 0; k < valores.size(); ++k) {
+                empaquetarFilaBits(fila, &mascaras[k][i * bytesFila], ancho, valores[k]);
+            }
+        }
+    });
+
+    bool correcto = true;
+    for (size_t k = 0; k < salidas.size(); ++k) {
+        correcto = guardarMascaraEnBMP(salidas[k].c_str(), mascaras[k].data(), ancho, alto) && correcto;
+    }
+    if (umbrales != nullptr) *umbrales = valores;
+    return correcto;
+}
@@ -0,0 +1,17 @@
+// Varios umbrales sobre la misma imagen: se lee y se convierte a gris una sola vez, y una sola pasada sobre el plano gris
+// produce una máscara de 1 bit por píxel para cada umbral, guardada como BMP monocromo.
+
+#ifndef VARIOS_H
+#define VARIOS_H
+
+#include <string>
+#include <vector>
+
+#include "lote.h"
+
+// salidas[k] recibe la máscara de metodos[k]. En umbrales (si no es nulo) se devuelven los umbrales aplicados.
+bool procesarVariosUmbrales(const std::string& entrada, const std::vector<std::string>& metodos,
+                            const std::vector<std::string>& salidas, const Ejecucion& ejecucion,
+                            std::vector<unsigned char>* umbrales = nullptr);
+
+#endif
@@ -0,0 +1,325 @@
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <map>
+#include <chrono>
+#include <algorithm>
+#include <cstdlib>
+
+#include "verificar.h"
+#include "backends.h"
+#include "generador.h"
+#include "medicion.h"
+
+using namespace std;
+
+// Solo se muestran las primeras diferencias; el resto solo cuenta
+const int MAX_FALLOS_MOSTRADOS = 20;
+
+struct CasoVerificacion {
+    int ancho;
+    int alto;
+    PatronSintetico patron;
+};
+
+struct CombinacionFormatos {
+    umbral_formato entrada;
+    umbral_formato salida;
+};
+
+// Las combinaciones que acepta umbral_procesar (ver umbral.h); la grande solo usa las dos primeras
+const CombinacionFormatos COMBINACIONES[] = {
+    {UMBRAL_FORMATO_BGR24, UMBRAL_FORMATO_BGR24},   {UMBRAL_FORMATO_BGR24, UMBRAL_FORMATO_GRIS8},
+    {UMBRAL_FORMATO_RGB24, UMBRAL_FORMATO_RGB24},   {UMBRAL_FORMATO_BGRA32, UMBRAL_FORMATO_BGRA32},
+    {UMBRAL_FORMATO_BGRA32, UMBRAL_FORMATO_GRIS8},  {UMBRAL_FORMATO_GRIS8, UMBRAL_FORMATO_GRIS8},
+};
+
+static const char* nombreFormato(umbral_formato formato) {
+    switch (formato) {
+    case UMBRAL_FORMATO_RGB24: return "rgb24";
+    case UMBRAL_FORMATO_BGRA32: return "bgra32";
+    case UMBRAL_FORMATO_GRIS8: return "gris8";
+    default: return "bgr24";
+    }
+}
+
+// Un buffer con su memoria. Las filas llevan 3 bytes de relleno, para que el paso no coincida con el ancho y ninguna
+// fila empiece alineada; con pasoNegativo la fila 0 es la última en memoria, como en un BMP visto de arriba abajo.
+struct BufferPrueba {
+    vector<unsigned char> bytes;
+    umbral_buffer buffer;
+
+    void preparar(int ancho, int alto, umbral_formato formato, bool pasoNegativo) {
+        ptrdiff_t paso = static_cast<ptrdiff_t>(ancho) * bytesPorPixel(formato) + 3;
+        bytes.assign(paso * alto, 0xCD);
+        buffer = umbral_buffer{bytes.data(), ancho, alto, paso, formato};
+        if (pasoNegativo) {
+            buffer.datos = bytes.data() + paso * (alto - 1);
+            buffer.paso = -paso;
+        }
+    }
+};
+
+// Las filas del generador en el formato pedido. En BGRA el alfa cambia con la columna para ver que se copia.
+static void llenarEntrada(BufferPrueba& entrada, const CasoVerificacion& caso, umbral_formato formato, bool pasoNegativo) {
+    entrada.preparar(caso.ancho, caso.alto, formato, pasoNegativo);
+    OpcionesGenerador generador;
+    generador.ancho = caso.ancho;
+    generador.alto = caso.alto;
+    generador.patron = caso.patron;
+    vector<Pixel> fila(caso.ancho);
+    for (int i = 0; i < caso.alto; ++i) {
+        generarFila(generador, i, fila.data());
+        unsigned char* destino = filaBuffer(entrada.buffer, i);
+        for (int j = 0; j < caso.ancho; ++j) {
+            const Pixel& p = fila[j];
+            switch (formato) {
+            case UMBRAL_FORMATO_RGB24:
+                destino[3 * j] = p.red;
+                destino[3 * j + 1] = p.green;
+                destino[3 * j + 2] = p.blue;
+                break;
+            case UMBRAL_FORMATO_BGRA32:
+                destino[4 * j] = p.blue;
+                destino[4 * j + 1] = p.green;
+                destino[4 * j + 2] = p.red;
+                destino[4 * j + 3] = static_cast<unsigned char>(j * 37 + i);
+                break;
+            case UMBRAL_FORMATO_GRIS8:
+                destino[j] = static_cast<unsigned char>((p.blue + p.green + p.red) / 3);
+                break;
+            default:
+                destino[3 * j] = p.blue;
+                destino[3 * j + 1] = p.green;
+                destino[3 * j + 2] = p.red;
+                break;
+            }
+        }
+    }
+}
+
+// La definición del umbralizado, píxel por píxel y sin nada de los kernels: el promedio entero de los tres canales (o
+// el valor, en gris) comparado con el umbral; 255 en todos los canales de color y el alfa sin cambios
+static void umbralizarReferencia(const umbral_buffer& entrada, const umbral_buffer& salida, unsigned char umbral) {
+    int bytesEntrada = bytesPorPixel(entrada.formato);
+    int bytesSalida = bytesPorPixel(salida.formato);
+    for (int i = 0; i < entrada.alto; ++i) {
+        for (int j = 0; j < entrada.ancho; ++j) {
+            const unsigned char* p = filaBuffer(entrada, i) + j * bytesEntrada;
+            unsigned char* q = filaBuffer(salida, i) + j * bytesSalida;
+            int gris = bytesEntrada == 1 ? p[0] : (p[0] + p[1] + p[2]) / 3;
+            unsigned char valor = gris < umbral ? 0 : 255;
+            for (int c = 0; c < min(bytesSalida, 3); ++c) q[c] = valor;
+            if (bytesSalida == 4) q[3] = p[3];
+        }
+    }
+}
+
+// "" si son iguales; si no, dónde está la primera diferencia. El relleno entre filas no se compara.
+static string compararSalida(const umbral_buffer& obtenida, const umbral_buffer& referencia) {
+    size_t bytesFila = static_cast<size_t>(referencia.ancho) * bytesPorPixel(referencia.formato);
+    int bytes = bytesPorPixel(referencia.formato);
+    for (int i = 0; i < referencia.alto; ++i) {
+        const unsigned char* a = filaBuffer(obtenida, i);
+        const unsigned char* b = filaBuffer(referencia, i);
+        auto diferencia = mismatch(a, a + bytesFila, b);
+        if (diferencia.first != a + bytesFila) {
+            size_t posicion = diferencia.first - a;
+            ostringstream motivo;
+            motivo << "difiere en la fila " << i << ", columna " << posicion / bytes << ", byte " << posicion % bytes
+                   << ": " << static_cast<int>(*diferencia.first) << " en lugar de " << static_cast<int>(*diferencia.second);
+            return motivo.str();
+        }
+    }
+    return "";
+}
+
+static vector<CasoVerificacion> conjuntoVerificacion(pair<int, int> grande) {
+    return {
+        {1, 1, PATRON_RUIDO},     {1, 97, PATRON_MIXTO},    {97, 1, PATRON_MIXTO},    {2, 3, PATRON_RUIDO},
+        {3, 5, PATRON_DEGRADADO}, {5, 3, PATRON_RUIDO},     {7, 9, PATRON_TEXTO},     {13, 11, PATRON_RUIDO},
+        {17, 64, PATRON_MIXTO},   {1023, 17, PATRON_MIXTO}, {641, 479, PATRON_MIXTO},
+        {grande.first, grande.second, PATRON_MIXTO},
+    };
+}
+
+struct ResultadoVerificacion {
+    int casos = 0;
+    int fallos = 0;
+};
+
+// Todas las configuraciones de backend sobre una entrada y su referencia
+static void verificarEntrada(const umbral_buffer& entrada, const umbral_buffer& referencia, umbral_formato formatoSalida,
+                             unsigned char umbral, const vector<int>& hilos, const string& descripcion,
+                             ResultadoVerificacion& resultado) {
+    bool mismoFormato = entrada.formato == formatoSalida;
+    BufferPrueba salida;
+    for (const Backend& backend : backendsRegistrados()) {
+        if (!backend.capacidades.disponible) continue;
+        for (umbral_kernel kernel : {UMBRAL_KERNEL_ESCALAR, UMBRAL_KERNEL_TABLA}) {
+            for (int numHilos : hilos) {
+                if (!backend.capacidades.paralelo && numHilos > 1) continue;
+                for (int filasPorBloque : {0, 5}) {
+                    if (!backend.capacidades.paralelo && filasPorBloque > 0) continue;
+                    // Con el mismo formato también se prueba sobre la misma memoria, como en el modo por lotes
+                    for (bool enElLugar : {false, true}) {
+                        if (enElLugar && !mismoFormato) continue;
+                        salida.preparar(entrada.ancho, entrada.alto, formatoSalida, false);
+                        umbral_buffer destino = salida.buffer;
+                        TrabajoUmbral trabajo{entrada, destino, umbral, kernel, filasPorBloque};
+                        if (enElLugar) {
+                            // Una copia de la entrada con el mismo paso; el relleno queda como estaba
+                            for (int i = 0; i < entrada.alto; ++i) {
+                                copy(filaBuffer(entrada, i),
+                                     filaBuffer(entrada, i) + static_cast<size_t>(entrada.ancho) * bytesPorPixel(entrada.formato),
+                                     filaBuffer(destino, i));
+                            }
+                            trabajo.entrada = destino;
+                        }
+                        int estado = ejecutarBackend(backend.id, trabajo, numHilos);
+                        string motivo = estado != UMBRAL_OK ? umbral_mensaje(estado) : compararSalida(destino, referencia);
+                        ++resultado.casos;
+                        if (motivo.empty()) continue;
+                        if (++resultado.fallos <= MAX_FALLOS_MOSTRADOS) {
+                            cerr << "FALLA: " << backend.nombre << " kernel=" << nombreKernel(kernel) << " hilos=" << numHilos
+                                 << " filas-por-bloque=" << filasPorBloque << (enElLugar ? " en el lugar " : " ")
+                                 << descripcion << ": " << motivo << endl;
+                        }
+                    }
+                }
+            }
+        }
+    }
+}
+
+// Rendimiento por "backend,kernel,hilos,ancho,alto"
+typedef map<string, double> LineaBase;
+
+static string claveRendimiento(const string& backend, const string& kernel, int hilos, int ancho, int alto) {
+    ostringstream clave;
+    clave << backend << "," << kernel << "," << hilos << "," << ancho << "," << alto;
+    return clave.str();
+}
+
+// Lee el CSV que escribe guardarLineaBase (backend,kernel,hilos,ancho,alto,mpx_s); una línea mal formada invalida el
+// archivo entero, porque comparar contra una línea base a medias escondería regresiones
+static bool leerLineaBase(const string& ruta, LineaBase& lineaBase) {
+    ifstream archivo(ruta);
+    if (!archivo) return false;
+    string linea;
+    getline(archivo, linea); // encabezado
+    int numLinea = 1;
+    while (getline(archivo, linea)) {
+        ++numLinea;
+        if (linea.empty()) continue;
+        size_t ultimaComa = linea.rfind(',');
+        string valor = ultimaComa == string::npos ? "" : linea.substr(ultimaComa + 1);
+        char* fin = nullptr;
+        double mpxPorSegundo = strtod(valor.c_str(), &fin);
+        if (valor.empty() || *fin != '\0' || !(mpxPorSegundo > 0)) {
+            cerr << "Línea " << numLinea << " inválida en la línea base, se esperaba: backend,kernel,hilos,ancho,alto,mpx_s"
+                 << endl;
+            return false;
+        }
+        lineaBase[linea.substr(0, ultimaComa)] = mpxPorSegundo;
+    }
+    return true;
+}
+
+int ejecutarVerificar(const OpcionesVerificar& opciones) {
+    cout << endl << "MEDICIÓN DE FORMA VERIFICAR. .........." << endl;
+    auto inicio = chrono::steady_clock::now();
+
+    // Uno, pocos (con filas que no se reparten parejo) y los pedidos
+    vector<int> hilos = {1, 2, 3};
+    if (opciones.numHilos > 3) hilos.push_back(opciones.numHilos);
+
+    ResultadoVerificacion resultado;
+    vector<CasoVerificacion> conjunto = conjuntoVerificacion(opciones.tamanoGrande);
+    BufferPrueba entrada, referencia;
+    for (size_t c = 0; c < conjunto.size(); ++c) {
+        const CasoVerificacion& caso = conjunto[c];
+        bool grande = c == conjunto.size() - 1;
+        for (const CombinacionFormatos& combinacion : COMBINACIONES) {
+            if (grande && combinacion.entrada != UMBRAL_FORMATO_BGR24) continue;
+            // Cada caso pequeño se prueba también con el paso negativo, uno sí y uno no
+            bool pasoNegativo = !grande && c % 2 == 1;
+            llenarEntrada(entrada, caso, combinacion.entrada, pasoNegativo);
+            for (int umbral : grande ? vector<int>{128} : vector<int>{0, 128, 255}) {
+                referencia.preparar(caso.ancho, caso.alto, combinacion.salida, false);
+                umbralizarReferencia(entrada.buffer, referencia.buffer, static_cast<unsigned char>(umbral));
+                ostringstream descripcion;
+                descripcion << nombreFormato(combinacion.entrada) << "->" << nombreFormato(combinacion.salida) << " "
+                            << caso.ancho << "x" << caso.alto << (pasoNegativo ? " (paso negativo)" : "") << " umbral "
+                            << umbral;
+                verificarEntrada(entrada.buffer, referencia.buffer, combinacion.salida, static_cast<unsigned char>(umbral),
+                                 hilos, descripcion.str(), resultado);
+            }
+        }
+    }
+    cout << "salidas iguales a la referencia: " << resultado.casos - resultado.fallos << "/" << resultado.casos << endl;
+
+    // Rendimiento: cada backend con cada kernel, con los hilos pedidos
+    LineaBase lineaBase;
+    bool conLineaBase = !opciones.lineaBase.empty() && !opciones.guardarLineaBase;
+    if (conLineaBase && !leerLineaBase(opciones.lineaBase, lineaBase)) {
+        cerr << "No se pudo leer la línea base: " << opciones.lineaBase << endl;
+        return 1;
+    }
+    TablaResultados tabla({"backend", "kernel", "hilos", "ancho", "alto", "mpx_s"});
+    Imagen imagen, salida;
+    imagenSintetica(imagen, opciones.tamanoRendimiento.first, opciones.tamanoRendimiento.second);
+    salida.ancho = imagen.ancho;
+    salida.alto = imagen.alto;
+    salida.pixeles.resize(imagen.numPixeles());
+    int regresiones = 0;
+    for (const Backend& backend : backendsRegistrados()) {
+        if (!backend.capacidades.disponible) continue;
+        int numHilos = backend.capacidades.paralelo ? opciones.numHilos : 1;
+        for (umbral_kernel kernel : {UMBRAL_KERNEL_ESCALAR, UMBRAL_KERNEL_TABLA}) {
+            TrabajoUmbral trabajo{bufferDeImagen(imagen), bufferDeImagen(salida), 128, kernel};
+            bool correcto = ejecutarBackend(backend.id, trabajo, numHilos) == UMBRAL_OK;
+            vector<double> tiempos;
+            for (int r = 0; r < opciones.repeticiones && correcto; ++r) {
+                auto inicioRepeticion = chrono::steady_clock::now();
+                correcto = ejecutarBackend(backend.id, trabajo, numHilos) == UMBRAL_OK;
+                tiempos.push_back(microsegundosDesde(inicioRepeticion));
+            }
+            if (!correcto) {
+                cerr << "Falló el backend " << backend.nombre << " al medir el rendimiento" << endl;
+                ++regresiones;
+                continue;
+            }
+            double mpxPorSegundo = imagen.numPixeles() / calcularEstadisticas(tiempos).mediana;
+            tabla.agregar({backend.nombre, nombreKernel(kernel), numHilos, imagen.ancho, imagen.alto, mpxPorSegundo});
+            cout << "rendimiento " << backend.nombre << " kernel=" << nombreKernel(kernel) << " hilos=" << numHilos << ": "
+                 << mpxPorSegundo << " Mpx/s";
+            auto base = lineaBase.find(claveRendimiento(backend.nombre, nombreKernel(kernel), numHilos, imagen.ancho,
+                                                        imagen.alto));
+            if (base != lineaBase.end() && base->second > 0) {
+                double proporcion = mpxPorSegundo / base->second;
+                cout << " (línea base " << base->second << ", " << 100 * proporcion << "%)";
+                if (proporcion < 1 - opciones.tolerancia) {
+                    cout << " REGRESIÓN";
+                    ++regresiones;
+                }
+            } else if (conLineaBase) {
+                cout << " (sin línea base)";
+            }
+            cout << endl;
+        }
+    }
+
+    if (opciones.guardarLineaBase) {
+        ofstream archivo(opciones.lineaBase);
+        tabla.escribirCSV(archivo);
+        if (!archivo) {
+            cerr << "No se pudo escribir la línea base en " << opciones.lineaBase << endl;
+            return 1;
+        }
+        cout << "línea base guardada en " << opciones.lineaBase << endl;
+    }
+    cout << "regresiones de rendimiento: " << regresiones << endl;
+    cout << "tiempo verificar: " << static_cast<long long>(microsegundosDesde(inicio)) << endl;
+    return resultado.fallos == 0 && regresiones == 0 ? 0 : 1;
+}
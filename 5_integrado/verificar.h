@@ -0,0 +1,25 @@
+// Comando verificar: umbraliza un conjunto de imágenes generadas (anchos impares, una sola fila, una sola columna, una
+// grande) con cada backend, kernel, cantidad de hilos, reparto de filas y combinación de formatos, y compara cada salida
+// byte a byte con una referencia escalar escrita aparte de los kernels. Después mide el rendimiento de cada backend y,
+// si hay una línea base guardada, falla si alguno rinde menos que ella por más de la tolerancia. Termina con 1 si algo
+// falló, para usarlo antes de aceptar un cambio.
+
+#ifndef VERIFICAR_H
+#define VERIFICAR_H
+
+#include <string>
+#include <utility>
+
+struct OpcionesVerificar {
+    int numHilos;
+    std::pair<int, int> tamanoGrande;      // la imagen grande del conjunto
+    std::pair<int, int> tamanoRendimiento; // la imagen con la que se mide el rendimiento
+    int repeticiones;
+    std::string lineaBase;  // CSV con el rendimiento de referencia; vacío para no medir contra nada
+    bool guardarLineaBase;  // escribe el rendimiento medido en lineaBase en lugar de compararlo
+    double tolerancia;      // 0.2: falla si un backend rinde menos del 80% de la línea base
+};
+
+int ejecutarVerificar(const OpcionesVerificar& opciones);
+
+#endif
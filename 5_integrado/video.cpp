@@ -0,0 +1,251 @@
+#include <iostream>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <chrono>
+#include <memory>
+#include <cerrno>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#include "video.h"
+#include "teselas.h"
+
+using namespace std;
+
+bool formatoPorNombre(const string& nombre, umbral_formato& formato) {
+    if (nombre == "bgr24") formato = UMBRAL_FORMATO_BGR24;
+    else if (nombre == "rgb24") formato = UMBRAL_FORMATO_RGB24;
+    else if (nombre == "bgra32") formato = UMBRAL_FORMATO_BGRA32;
+    else if (nombre == "gris8") formato = UMBRAL_FORMATO_GRIS8;
+    else return false;
+    return true;
+}
+
+bool formatoVideoPorNombre(const string& nombre, OpcionesVideo& opciones) {
+    opciones.yuv420 = nombre == "yuv420p" || nombre == "nv12";
+    if (opciones.yuv420) {
+        opciones.formato = UMBRAL_FORMATO_GRIS8;
+        opciones.salidaGris = true;
+        return true;
+    }
+    return formatoPorNombre(nombre, opciones.formato);
+}
+
+// Lee exactamente n bytes salvo al final del archivo; devuelve cuántos leyó, o -1 si hubo un error
+static ssize_t leerCompleto(int descriptor, unsigned char* datos, size_t n) {
+    size_t leidos = 0;
+    while (leidos < n) {
+        ssize_t r = read(descriptor, datos + leidos, n - leidos);
+        if (r < 0 && errno == EINTR) continue;
+        if (r < 0) return -1;
+        if (r == 0) break;
+        leidos += r;
+    }
+    return leidos;
+}
+
+static bool escribirCompleto(int descriptor, const unsigned char* datos, size_t n) {
+    while (n > 0) {
+        ssize_t r = write(descriptor, datos, n);
+        if (r < 0 && errno == EINTR) continue;
+        if (r <= 0) return false;
+        datos += r;
+        n -= r;
+    }
+    return true;
+}
+
+// Hilo que escribe un cuadro mientras el hilo principal lee y umbraliza el siguiente. Solo hay un cuadro pendiente a
+// la vez: entregar espera a que termine la escritura anterior, así que con dos buffers de salida alternados nunca se
+// escribe sobre un buffer que todavía se está guardando.
+class EscritorAsincrono {
+public:
+    explicit EscritorAsincrono(int descriptor) : descriptor(descriptor), hilo(&EscritorAsincrono::trabajar, this) {}
+
+    ~EscritorAsincrono() {
+        {
+            lock_guard<mutex> lock(mtx);
+            terminar = true;
+        }
+        cambio.notify_all();
+        hilo.join();
+    }
+
+    // Devuelve false si alguna escritura anterior falló
+    bool entregar(const unsigned char* datos, size_t n) {
+        unique_lock<mutex> lock(mtx);
+        cambio.wait(lock, [&] { return pendiente == nullptr; });
+        if (error) return false;
+        pendiente = datos;
+        tamano = n;
+        cambio.notify_all();
+        return true;
+    }
+
+    bool esperar() {
+        unique_lock<mutex> lock(mtx);
+        cambio.wait(lock, [&] { return pendiente == nullptr; });
+        return !error;
+    }
+
+private:
+    void trabajar() {
+        unique_lock<mutex> lock(mtx);
+        while (true) {
+            cambio.wait(lock, [&] { return pendiente != nullptr || terminar; });
+            if (pendiente == nullptr) return;
+            const unsigned char* datos = pendiente;
+            size_t n = tamano;
+            lock.unlock();
+            bool correcto = escribirCompleto(descriptor, datos, n);
+            lock.lock();
+            if (!correcto) error = true;
+            pendiente = nullptr;
+            cambio.notify_all();
+        }
+    }
+
+    int descriptor;
+    mutex mtx;
+    condition_variable cambio;
+    const unsigned char* pendiente = nullptr;
+    size_t tamano = 0;
+    bool error = false;
+    bool terminar = false;
+    thread hilo;
+};
+
+// Suavizado exponencial del umbral automático entre cuadros, para que no parpadee con el ruido. Con peso 1 se usa el
+// umbral de cada cuadro tal cual.
+class UmbralTemporal {
+public:
+    explicit UmbralTemporal(double peso) : peso(peso) {}
+
+    unsigned char siguiente(const size_t histograma[256], const string& metodo) {
+        double actual = umbralDeHistograma(histograma, metodo);
+        acumulado = acumulado < 0 ? actual : acumulado + peso * (actual - acumulado);
+        return static_cast<unsigned char>(acumulado + 0.5);
+    }
+
+private:
+    double peso;
+    double acumulado = -1;
+};
+
+bool procesarVideo(const string& entrada, const string& salida, const OpcionesVideo& opciones,
+                   ResultadoVideo& resultado) {
+    int descriptorEntrada = entrada == "-" ? STDIN_FILENO : open(entrada.c_str(), O_RDONLY | O_CLOEXEC);
+    if (descriptorEntrada < 0) {
+        cerr << "No se pudo abrir la entrada: " << entrada << endl;
+        return false;
+    }
+    int descriptorSalida = salida == "-" ? STDOUT_FILENO : open(salida.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (descriptorSalida < 0) {
+        cerr << "No se pudo crear la salida: " << salida << endl;
+        if (descriptorEntrada != STDIN_FILENO) close(descriptorEntrada);
+        return false;
+    }
+
+    umbral_formato formatoSalida = opciones.salidaGris ? UMBRAL_FORMATO_GRIS8 : opciones.formato;
+    size_t pasoEntrada = static_cast<size_t>(opciones.ancho) * bytesPorPixel(opciones.formato);
+    size_t pasoSalida = static_cast<size_t>(opciones.ancho) * bytesPorPixel(formatoSalida);
+    size_t bytesEntrada = pasoEntrada * opciones.alto;
+    if (opciones.yuv420) {
+        // Dos planos de color (U y V, o UV intercalados en NV12) submuestreados a la mitad en cada dirección
+        bytesEntrada += 2 * (static_cast<size_t>(opciones.ancho + 1) / 2) * ((opciones.alto + 1) / 2);
+    }
+    size_t bytesSalida = pasoSalida * opciones.alto;
+
+    // Un buffer de entrada y dos de salida, reservados una sola vez. El modo incremental alterna dos buffers de entrada
+    // para comparar cada cuadro con el anterior sin copiarlo.
+    bool incremental = opciones.tesela > 0;
+    vector<unsigned char> cuadros[2] = {vector<unsigned char>(bytesEntrada), vector<unsigned char>(incremental ? bytesEntrada : 0)};
+    vector<unsigned char> salidas[2] = {vector<unsigned char>(bytesSalida), vector<unsigned char>(bytesSalida)};
+
+    // El backend se resuelve una vez: todos los cuadros tienen el mismo tamaño
+    TrabajoUmbral trabajo{umbral_buffer{cuadros[0].data(), opciones.ancho, opciones.alto, static_cast<ptrdiff_t>(pasoEntrada), opciones.formato},
+                          umbral_buffer{salidas[0].data(), opciones.ancho, opciones.alto, static_cast<ptrdiff_t>(pasoSalida), formatoSalida},
+                          0, opciones.ejecucion.kernel, opciones.ejecucion.filasPorBloque};
+    umbral_backend backend = opciones.ejecucion.backend;
+    int numHilos = opciones.ejecucion.numHilos;
+    if (backend == UMBRAL_BACKEND_AUTO) {
+        backend = resolverAuto(trabajo, numHilos);
+    }
+    // Con un método automático y teselas, el histograma se actualiza solo con las teselas que cambiaron
+    bool automatico = opciones.metodo == "otsu" || opciones.metodo == "media";
+    UmbralTemporal umbralTemporal(opciones.suavizado);
+    size_t histograma[256];
+
+    // El modo incremental reparte franjas de teselas en el pool en lugar de usar el backend
+    unique_ptr<UmbralizadorIncremental> porTeselas;
+    PoolHilos* pool = nullptr;
+    if (incremental) {
+        porTeselas.reset(new UmbralizadorIncremental(opciones.ancho, opciones.alto, opciones.tesela, automatico));
+        if (backend != UMBRAL_BACKEND_SECUENCIAL && numHilos > 1) {
+            pool = opciones.ejecucion.pool != nullptr ? opciones.ejecucion.pool : &poolCompartido(numHilos);
+        }
+    }
+
+    bool correcto = true;
+    auto inicio = chrono::steady_clock::now();
+    {
+        EscritorAsincrono escritor(descriptorSalida);
+        while (true) {
+            vector<unsigned char>& cuadro = cuadros[incremental ? resultado.cuadros % 2 : 0];
+            ssize_t leidos = leerCompleto(descriptorEntrada, cuadro.data(), bytesEntrada);
+            if (leidos == 0) break;
+            if (leidos != static_cast<ssize_t>(bytesEntrada)) {
+                cerr << (leidos < 0 ? "Error al leer el cuadro " : "Cuadro incompleto al final de la entrada: ")
+                     << resultado.cuadros << endl;
+                correcto = false;
+                break;
+            }
+            vector<unsigned char>& destino = salidas[resultado.cuadros % 2];
+            trabajo.entrada.datos = cuadro.data();
+            trabajo.salida.datos = destino.data();
+            int estado = UMBRAL_OK;
+            if (incremental) {
+                const unsigned char* anterior = resultado.cuadros > 0 ? cuadros[(resultado.cuadros + 1) % 2].data() : nullptr;
+                porTeselas->comparar(trabajo.entrada, anterior, pool);
+            }
+            if (!automatico) {
+                trabajo.umbral = resolverUmbral(trabajo.entrada, opciones.metodo);
+            } else if (incremental) {
+                trabajo.umbral = umbralTemporal.siguiente(porTeselas->histograma(), opciones.metodo);
+            } else {
+                calcularHistograma(trabajo.entrada, histograma);
+                trabajo.umbral = umbralTemporal.siguiente(histograma, opciones.metodo);
+            }
+            if (incremental) {
+                resultado.teselasUmbralizadas += porTeselas->umbralizar(trabajo, resultado.cuadros % 2, pool);
+                resultado.teselas += porTeselas->numTeselas();
+            } else {
+                estado = ejecutarBackend(backend, trabajo, numHilos, opciones.ejecucion.pool);
+            }
+            if (estado != UMBRAL_OK) {
+                cerr << "Error al umbralizar el cuadro " << resultado.cuadros << ": " << umbral_mensaje(estado) << endl;
+                correcto = false;
+                break;
+            }
+            if (!escritor.entregar(destino.data(), bytesSalida)) {
+                correcto = false;
+                break;
+            }
+            ++resultado.cuadros;
+        }
+        if (!escritor.esperar()) {
+            cerr << "Error al escribir la salida: " << salida << endl;
+            correcto = false;
+        }
+    }
+    resultado.segundos = chrono::duration<double>(chrono::steady_clock::now() - inicio).count();
+
+    if (descriptorEntrada != STDIN_FILENO) close(descriptorEntrada);
+    if (descriptorSalida != STDOUT_FILENO && close(descriptorSalida) != 0) {
+        correcto = false;
+    }
+    return correcto;
+}
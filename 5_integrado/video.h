@@ -0,0 +1,42 @@
+// Modo video: umbraliza una secuencia de cuadros sin comprimir de tamaño y formato fijos, concatenados en un archivo o
+// en la entrada estándar (por ejemplo la salida de una cámara de barrido de líneas), y escribe los cuadros resultantes
+// concatenados de la misma forma.
+
+#ifndef VIDEO_H
+#define VIDEO_H
+
+#include <cstdint>
+#include <string>
+
+#include "lote.h"
+
+struct OpcionesVideo {
+    int ancho;
+    int alto;
+    umbral_formato formato; // en cuadros YUV es GRIS8: se umbraliza el plano Y tal como viene
+    bool yuv420;            // YUV420p o NV12: después del plano Y vienen los de color, que se leen pero no se usan
+    bool salidaGris;        // un byte por píxel en lugar del formato de entrada
+    std::string metodo;     // umbral fijo o método automático, calculado en cada cuadro
+    Ejecucion ejecucion;
+    int tesela = 0;         // lado de las teselas del modo incremental (ver teselas.h); 0 umbraliza cuadros enteros
+    double suavizado = 1;   // con métodos automáticos, peso del umbral del cuadro actual frente al acumulado (0..1]
+};
+
+struct ResultadoVideo {
+    uint64_t cuadros = 0;
+    double segundos = 0;
+    uint64_t teselas = 0;             // en el modo incremental, teselas de todos los cuadros
+    uint64_t teselasUmbralizadas = 0; // y cuántas de ellas hubo que volver a umbralizar
+};
+
+bool formatoPorNombre(const std::string& nombre, umbral_formato& formato);
+
+// Además de los formatos de formatoPorNombre acepta "yuv420p" y "nv12", que comparten tamaño y plano Y
+bool formatoVideoPorNombre(const std::string& nombre, OpcionesVideo& opciones);
+
+// entrada y salida son rutas o "-" para la entrada y salida estándar. Los buffers se reservan una vez y se reutilizan
+// en todos los cuadros, y la escritura de un cuadro se solapa con el umbralizado del siguiente.
+bool procesarVideo(const std::string& entrada, const std::string& salida, const OpcionesVideo& opciones,
+                   ResultadoVideo& resultado);
+
+#endif